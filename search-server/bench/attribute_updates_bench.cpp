@@ -0,0 +1,38 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestAttributeUpdates(SearchServer search_server, const vector<string>& documents, int update_count) {
+    {
+        LOG_DURATION("status updates, in place"sv);
+        for (int i = 0; i < update_count; ++i) {
+            const int document_id = i % documents.size();
+            search_server.SetDocumentStatus(document_id, i % 2 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED);
+            search_server.SetDocumentRating(document_id, { i % 10 });
+        }
+    }
+    {
+        LOG_DURATION("status updates, remove and add"sv);
+        for (int i = 0; i < update_count; ++i) {
+            const int document_id = i % documents.size();
+            search_server.RemoveDocument(document_id);
+            search_server.AddDocument(document_id, documents[document_id], i % 2 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED, { i % 10 });
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    TestAttributeUpdates(MakeSearchServer(corpus), corpus.documents, 10'000);
+}
@@ -0,0 +1,42 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../process_queries.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestBatch(string_view mark, const SearchServer& search_server, const vector<string>& queries) {
+    vector<vector<Document>> per_query;
+    vector<vector<Document>> shared;
+    {
+        LOG_DURATION("per query, "s + string(mark));
+        per_query = ProcessQueries(search_server, queries, BatchMode::PER_QUERY);
+    }
+    {
+        LOG_DURATION("shared, "s + string(mark));
+        shared = ProcessQueries(search_server, queries, BatchMode::SHARED);
+    }
+    int mismatches = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        mismatches += !AreSameDocuments(per_query[i], shared[i]);
+    }
+    cout << mark << ": mismatches = "s << mismatches << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+
+    TestBatch("zipf"sv, search_server, GenerateZipfQueries(generator, corpus.dictionary, 1000, 7));
+    TestBatch("zipf with minus words"sv, search_server, GenerateZipfQueries(generator, corpus.dictionary, 1000, 7, 0.2));
+}
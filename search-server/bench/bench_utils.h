@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+
+// Every benchmark in this directory is a program of its own: it prints the
+// durations of LOG_DURATION and, where it compares results, the mismatches found.
+// The corpus is the one of main.cpp.
+
+inline std::string GenerateWord(std::mt19937& generator, int max_length) {
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::uniform_int_distribution<int> distribution('a', 'z');
+    std::string word(length, ' ');
+    for (char& c : word) {
+        c = char(distribution(generator));
+    }
+    return word;
+}
+
+inline std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+inline std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count, double minus_prob = 0) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+inline std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary, int query_count, int max_word_count) {
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+// Words of the dictionary drawn with Zipfian frequencies: the k-th word is k times rarer than the first
+inline std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+    int query_count, int word_count, double minus_prob = 0) {
+    std::vector<double> weights;
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+        weights.push_back(1.0 / (i + 1));
+    }
+    std::discrete_distribution<size_t> word_distribution(weights.begin(), weights.end());
+    std::vector<std::string> queries;
+    for (int i = 0; i < query_count; ++i) {
+        std::string query;
+        for (int j = 0; j < word_count; ++j) {
+            if (!query.empty()) {
+                query.push_back(' ');
+            }
+            if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+                query.push_back('-');
+            }
+            query += dictionary[word_distribution(generator)];
+        }
+        queries.push_back(std::move(query));
+    }
+    return queries;
+}
+
+// 10000 documents of 70 words from a dictionary of 1000, the first word being the stop word
+struct Corpus {
+    std::vector<std::string> dictionary;
+    std::vector<std::string> documents;
+};
+
+inline Corpus GenerateCorpus(std::mt19937& generator) {
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, 1000, 10);
+    corpus.documents = GenerateQueries(generator, corpus.dictionary, 10'000, 70);
+    return corpus;
+}
+
+inline SearchServer MakeSearchServer(const Corpus& corpus) {
+    SearchServer search_server(corpus.dictionary[0]);
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        search_server.AddDocument(i, corpus.documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    return search_server;
+}
+
+inline bool AreSameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& left, const Document& right) {
+        return left.id == right.id && left.relevance == right.relevance && left.rating == right.rating;
+        });
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../document_loader.h"
+#include "../field_parsing.h"
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+// The documents of the corpus copy_count times over, one tab-separated line each
+string GenerateInput(const Corpus& corpus, int copy_count) {
+    string input;
+    int document_id = 0;
+    for (int copy = 0; copy < copy_count; ++copy) {
+        for (const string& document : corpus.documents) {
+            input += to_string(document_id++) + "\tACTUAL\t1,2,3\t"s + document + '\n';
+        }
+    }
+    return input;
+}
+
+// Each line read, parsed and passed to AddDocument by the calling thread alone
+size_t LoadLineByLine(SearchServer& search_server, istream& input) {
+    size_t document_count = 0;
+    string line;
+    while (getline(input, line)) {
+        string_view rest = line;
+        vector<string_view> fields;
+        for (int field = 0; field < 3; ++field) {
+            const size_t tab = rest.find('\t');
+            if (tab == rest.npos) {
+                throw invalid_argument("Expected 4 tab-separated fields"s);
+            }
+            fields.push_back(rest.substr(0, tab));
+            rest.remove_prefix(tab + 1);
+        }
+        search_server.AddDocument(ParseInt(fields[0]), rest, ParseStatus(fields[1]), ParseRatings(fields[2]));
+        ++document_count;
+    }
+    return document_count;
+}
+
+void TestLoad(const Corpus& corpus, int copy_count) {
+    const string input = GenerateInput(corpus, copy_count);
+    const string mark = to_string(input.size() >> 20) + " MB"s;
+    {
+        SearchServer search_server(corpus.dictionary[0]);
+        istringstream stream(input);
+        LOG_DURATION("line by line, "s + mark);
+        cout << LoadLineByLine(search_server, stream) << endl;
+    }
+    {
+        SearchServer search_server(corpus.dictionary[0]);
+        istringstream stream(input);
+        LOG_DURATION("LoadDocuments, "s + mark);
+        const LoadReport report = LoadDocuments(search_server, stream);
+        cout << report.document_count << ", errors = "s << report.error_count << endl;
+    }
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    TestLoad(corpus, 1);
+    TestLoad(corpus, 5);
+}
@@ -0,0 +1,57 @@
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../document_store.h"
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestDocumentStore(const vector<string>& documents, const vector<string>& queries) {
+    const auto path = filesystem::temp_directory_path() / "search_server_documents.bin";
+    {
+        SearchServer search_server(""s);
+        search_server.SetDocumentStore(make_shared<DocumentStore>(path.string()));
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+        {
+            LOG_DURATION("document store, search and texts of top hits"sv);
+            int mismatches = 0;
+            for (const string_view query : queries) {
+                for (const auto& document : search_server.FindTopDocuments(query)) {
+                    mismatches += search_server.GetDocumentText(document.id) != documents[document.id];
+                }
+            }
+            cout << "document store: mismatches = "s << mismatches << endl;
+        }
+        const MemoryUsage usage = search_server.GetMemoryUsage();
+        size_t text_size = 0;
+        for (const string& document : documents) {
+            text_size += document.size();
+        }
+        cout << "document store: text = "s << text_size << " bytes, memory = "s << usage.document_store
+            << " of "s << usage.GetTotal() << " bytes, file = "s << filesystem::file_size(path) << " bytes"s << endl;
+    }
+    // The store keeps the file open as long as the server holds it
+    filesystem::remove(path);
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+    cout << "memory store: "s << search_server.GetMemoryUsage().document_store << " of "s
+        << search_server.GetMemoryUsage().GetTotal() << " bytes"s << endl;
+
+    TestDocumentStore(corpus.documents, GenerateQueries(generator, corpus.dictionary, 100, 70));
+}
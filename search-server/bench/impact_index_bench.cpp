@@ -0,0 +1,47 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../impact_index.h"
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestImpactIndex(string_view mark, const SearchServer& search_server, const vector<string>& queries, ImpactPrecision precision) {
+    const ImpactIndex impact_index(search_server, precision);
+    {
+        LOG_DURATION(mark);
+        double total_relevance = 0;
+        for (const string_view query : queries) {
+            for (const auto& document : impact_index.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+
+    // The approximate scores must not change anything in the final top documents
+    int mismatches = 0;
+    for (const string_view query : queries) {
+        mismatches += !AreSameDocuments(search_server.FindTopDocuments(query), impact_index.FindTopDocuments(query));
+    }
+    cout << mark << ": mismatches = "s << mismatches << ", memory = "s << impact_index.GetMemoryUsage() << " bytes"s << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+
+    const auto queries = GenerateQueries(generator, corpus.dictionary, 100, 70);
+    TestImpactIndex("impact float32"sv, search_server, queries, ImpactPrecision::FLOAT32);
+    TestImpactIndex("impact uint16"sv, search_server, queries, ImpactPrecision::UINT16);
+    TestImpactIndex("impact uint8"sv, search_server, queries, ImpactPrecision::UINT8);
+}
@@ -0,0 +1,47 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestIngest(string_view mark, const vector<string>& stop_words, const vector<string>& documents) {
+    SearchServer search_server(stop_words);
+    LOG_DURATION(mark);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    cout << search_server.GetDocumentCount() << endl;
+}
+
+// Every document brings a new word and is followed by a prefix query, as when queries are served during ingest
+void TestPrefixIngest(string_view mark, const vector<string>& documents) {
+    SearchServer search_server(""s);
+    LOG_DURATION(mark);
+    size_t found_count = 0;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const string word = "new"s + to_string(i);
+        search_server.AddDocument(i, documents[i] + " "s + word, DocumentStatus::ACTUAL, { 1, 2, 3 });
+        found_count += search_server.FindTopDocuments(word.substr(0, word.size() - 1) + "*"s).size();
+    }
+    cout << found_count << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+
+    for (const size_t stop_word_count : { 0, 50, 500 }) {
+        const vector<string> stop_words(corpus.dictionary.begin(), corpus.dictionary.begin() + stop_word_count);
+        TestIngest("ingest, stop words: "s + to_string(stop_word_count), stop_words, corpus.documents);
+    }
+    TestPrefixIngest("ingest with prefix queries"sv, corpus.documents);
+}
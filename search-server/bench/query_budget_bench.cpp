@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+void TestBudget(string_view mark, const SearchServer& search_server, const vector<string>& queries, const QueryBudget& budget) {
+    vector<SearchResult> results;
+    {
+        LOG_DURATION(mark);
+        for (const string_view query : queries) {
+            results.push_back(search_server.FindTopDocuments(query, budget));
+        }
+    }
+    // Share of the exact top documents found within the budget
+    int approximate_count = 0;
+    size_t found_count = 0;
+    size_t exact_count = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        approximate_count += results[i].is_approximate;
+        for (const Document& expected : search_server.FindTopDocuments(queries[i])) {
+            ++exact_count;
+            found_count += any_of(results[i].documents.begin(), results[i].documents.end(), [&expected](const Document& document) {
+                return document.id == expected.id;
+                });
+        }
+    }
+    cout << mark << ": approximate = "s << approximate_count << ", recall = "s << (exact_count == 0 ? 1.0 : found_count * 1.0 / exact_count) << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+
+    const auto queries = GenerateQueries(generator, corpus.dictionary, 100, 70);
+    for (const size_t max_postings : { 1'000, 10'000, 100'000 }) {
+        QueryBudget budget;
+        budget.max_postings = max_postings;
+        TestBudget("budget, postings: "s + to_string(max_postings), search_server, queries, budget);
+    }
+}
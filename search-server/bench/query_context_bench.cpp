@@ -0,0 +1,46 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+// The allocations of these queries are checked by tests/query_allocations_test.cpp
+void TestQueryContext(string_view mark, const SearchServer& search_server, const vector<string>& queries) {
+    SearchServer::QueryContext context;
+    for (const string_view query : queries) {
+        search_server.FindTopDocuments(context, query);
+    }
+    double total_relevance = 0;
+    {
+        LOG_DURATION(mark);
+        for (const string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(context, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+    }
+    cout << total_relevance << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+
+    const auto queries = GenerateQueries(generator, corpus.dictionary, 100, 70);
+    vector<string> minus_queries;
+    for (int i = 0; i < 100; ++i) {
+        minus_queries.push_back(GenerateQuery(generator, corpus.dictionary, 70, 0.1));
+    }
+    TestQueryContext("query context"sv, search_server, queries);
+    TestQueryContext("query context, minus words"sv, search_server, minus_queries);
+}
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../log_duration.h"
+#include "../search_server.h"
+#include "bench_utils.h"
+
+using namespace std;
+
+namespace {
+
+// The first page_count pages of every query
+void TestPages(string_view mark, const SearchServer& search_server, const vector<string>& queries, size_t page_size, int page_count) {
+    LOG_DURATION(mark);
+    size_t document_count = 0;
+    for (const string_view query : queries) {
+        SearchPage page = search_server.FindFirstPage(query, page_size);
+        for (int i = 1; ; ++i) {
+            document_count += page.documents.size();
+            if (i == page_count || page.next.IsEnd()) {
+                break;
+            }
+            page = search_server.FetchNextPage(page.next, page_size);
+        }
+    }
+    cout << document_count << endl;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator;
+    const Corpus corpus = GenerateCorpus(generator);
+    const SearchServer search_server = MakeSearchServer(corpus);
+
+    const auto queries = GenerateZipfQueries(generator, corpus.dictionary, 100, 5);
+    TestPages("pages of 10: 1"sv, search_server, queries, 10, 1);
+    TestPages("pages of 10: 10"sv, search_server, queries, 10, 10);
+}
@@ -0,0 +1,68 @@
+#include "document_attributes.h"
+
+using namespace std;
+
+DocumentAttributes::DocumentAttributes(const DocumentAttributes& other)
+    : document_ids_(other.document_ids_)
+    , ratings_(other.ratings_)
+    , statuses_(other.statuses_)
+    , status_bitmaps_(other.status_bitmaps_)
+    , free_slots_(other.free_slots_) {
+}
+
+DocumentAttributes& DocumentAttributes::operator=(const DocumentAttributes& other) {
+    document_ids_ = other.document_ids_;
+    ratings_ = other.ratings_;
+    statuses_ = other.statuses_;
+    status_bitmaps_ = other.status_bitmaps_;
+    free_slots_ = other.free_slots_;
+    return *this;
+}
+
+int DocumentAttributes::Add(int document_id, DocumentStatus status, int rating) {
+    int slot;
+    if (free_slots_.empty()) {
+        slot = GetSlotCount();
+        document_ids_.push_back(document_id);
+        ratings_.PushBack(rating);
+        statuses_.PushBack(status);
+        for (AtomicColumn<uint64_t>& bitmap : status_bitmaps_) {
+            bitmap.Resize(slot / 64 + 1);
+        }
+    }
+    else {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        document_ids_[slot] = document_id;
+        ratings_.Set(slot, rating);
+        statuses_.Set(slot, status);
+    }
+    SetStatusBit(slot, status);
+    return slot;
+}
+
+void DocumentAttributes::Remove(int slot) {
+    ResetStatusBit(slot, statuses_.Get(slot));
+    document_ids_[slot] = -1;
+    free_slots_.push_back(slot);
+}
+
+void DocumentAttributes::SetStatus(int slot, DocumentStatus status) {
+    lock_guard lock(status_mutex_);
+    const DocumentStatus old_status = statuses_.Get(slot);
+    if (old_status == status) {
+        return;
+    }
+    SetStatusBit(slot, status);
+    statuses_.Set(slot, status);
+    ResetStatusBit(slot, old_status);
+}
+
+size_t DocumentAttributes::GetMemoryUsage() const {
+    size_t usage = (document_ids_.capacity() + free_slots_.capacity()) * sizeof(int)
+        + ratings_.GetMemoryUsage() + statuses_.GetMemoryUsage();
+    for (const AtomicColumn<uint64_t>& bitmap : status_bitmaps_) {
+        usage += bitmap.GetMemoryUsage();
+    }
+    return usage;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+
+const int DOCUMENT_STATUS_COUNT = static_cast<int>(DocumentStatus::REMOVED) + 1;
+
+// Predicates recognized by SearchServer at compile time. They are answered
+// from the attribute columns and status bitmaps without calling anything per
+// document; they still work as ordinary predicates everywhere else.
+struct StatusFilter {
+    DocumentStatus status = DocumentStatus::ACTUAL;
+
+    bool operator()(int, DocumentStatus document_status, int) const {
+        return document_status == status;
+    }
+};
+
+struct RatingRange {
+    int min_rating;
+    int max_rating;
+
+    bool operator()(int, DocumentStatus, int rating) const {
+        return min_rating <= rating && rating <= max_rating;
+    }
+};
+
+// Bit per document slot
+class SlotBitmap {
+public:
+    void Set(int slot) {
+        Reserve(slot);
+        words_[slot / 64] |= uint64_t{ 1 } << (slot % 64);
+    }
+
+    void Reset(int slot) {
+        if (static_cast<size_t>(slot / 64) < words_.size()) {
+            words_[slot / 64] &= ~(uint64_t{ 1 } << (slot % 64));
+        }
+    }
+
+    void Clear() {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+    bool Test(int slot) const {
+        const size_t word = slot / 64;
+        return word < words_.size() && (words_[word] >> (slot % 64)) & 1;
+    }
+
+    size_t GetMemoryUsage() const {
+        return words_.capacity() * sizeof(uint64_t);
+    }
+
+private:
+    void Reserve(int slot) {
+        if (static_cast<size_t>(slot / 64) >= words_.size()) {
+            words_.resize(slot / 64 + 1);
+        }
+    }
+
+    std::vector<uint64_t> words_;
+};
+
+// Column of values that may be read and written by several threads at once.
+// Growing it is not thread-safe, just as adding documents is not.
+template <typename T>
+class AtomicColumn {
+public:
+    AtomicColumn() = default;
+
+    AtomicColumn(const AtomicColumn& other) {
+        *this = other;
+    }
+
+    AtomicColumn(AtomicColumn&& other) noexcept
+        : values_(std::move(other.values_))
+        , size_(std::exchange(other.size_, 0))
+        , capacity_(std::exchange(other.capacity_, 0)) {
+    }
+
+    AtomicColumn& operator=(const AtomicColumn& other) {
+        if (this != &other) {
+            AtomicColumn copy;
+            copy.Resize(other.size_);
+            for (size_t i = 0; i < other.size_; ++i) {
+                copy.Set(i, other.Get(i));
+            }
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    AtomicColumn& operator=(AtomicColumn&& other) noexcept {
+        values_ = std::move(other.values_);
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        return *this;
+    }
+
+    T Get(size_t index) const {
+        return values_[index].load(std::memory_order_relaxed);
+    }
+
+    void Set(size_t index, T value) {
+        values_[index].store(value, std::memory_order_relaxed);
+    }
+
+    void FetchOr(size_t index, T mask) {
+        values_[index].fetch_or(mask, std::memory_order_relaxed);
+    }
+
+    void FetchAnd(size_t index, T mask) {
+        values_[index].fetch_and(mask, std::memory_order_relaxed);
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+    // Grows the column, filling the new values with value
+    void Resize(size_t size, T value = T{}) {
+        if (size > capacity_) {
+            const size_t capacity = std::max(size, capacity_ * 2);
+            auto values = std::make_unique<std::atomic<T>[]>(capacity);
+            for (size_t i = 0; i < size_; ++i) {
+                values[i].store(Get(i), std::memory_order_relaxed);
+            }
+            values_ = std::move(values);
+            capacity_ = capacity;
+        }
+        for (size_t i = size_; i < size; ++i) {
+            Set(i, value);
+        }
+        size_ = std::max(size_, size);
+    }
+
+    void PushBack(T value) {
+        Resize(size_ + 1, value);
+    }
+
+    size_t GetMemoryUsage() const {
+        return capacity_ * sizeof(std::atomic<T>);
+    }
+
+private:
+    std::unique_ptr<std::atomic<T>[]> values_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+// Rating and status of the documents stored as dense columns indexed by
+// an internal slot, plus a bitmap of slots for every status.
+// Slots of removed documents are reused.
+//
+// SetStatus and SetRating may be called while other threads read the
+// attributes: a reader sees either the old or the new value. A status change
+// sets the new bit before it clears the old one, so a document is never
+// missing from both bitmaps. Add and Remove need exclusive access.
+class DocumentAttributes {
+public:
+    DocumentAttributes() = default;
+
+    DocumentAttributes(const DocumentAttributes& other);
+
+    DocumentAttributes& operator=(const DocumentAttributes& other);
+
+    int Add(int document_id, DocumentStatus status, int rating);
+
+    void Remove(int slot);
+
+    void SetStatus(int slot, DocumentStatus status);
+
+    void SetRating(int slot, int rating) {
+        ratings_.Set(slot, rating);
+    }
+
+    int GetDocumentId(int slot) const {
+        return document_ids_[slot];
+    }
+
+    DocumentStatus GetStatus(int slot) const {
+        return statuses_.Get(slot);
+    }
+
+    int GetRating(int slot) const {
+        return ratings_.Get(slot);
+    }
+
+    bool HasStatus(int slot, DocumentStatus status) const {
+        const AtomicColumn<uint64_t>& bitmap = status_bitmaps_[static_cast<int>(status)];
+        const size_t word = slot / 64;
+        return word < bitmap.GetSize() && (bitmap.Get(word) >> (slot % 64)) & 1;
+    }
+
+    // Upper bound of the slots in use
+    int GetSlotCount() const {
+        return static_cast<int>(document_ids_.size());
+    }
+
+    size_t GetMemoryUsage() const;
+
+private:
+    void SetStatusBit(int slot, DocumentStatus status) {
+        status_bitmaps_[static_cast<int>(status)].FetchOr(slot / 64, uint64_t{ 1 } << (slot % 64));
+    }
+
+    void ResetStatusBit(int slot, DocumentStatus status) {
+        status_bitmaps_[static_cast<int>(status)].FetchAnd(slot / 64, ~(uint64_t{ 1 } << (slot % 64)));
+    }
+
+    std::vector<int> document_ids_;
+    AtomicColumn<int> ratings_;
+    AtomicColumn<DocumentStatus> statuses_;
+    // Every bitmap covers all the slots, so a status change never grows one
+    std::array<AtomicColumn<uint64_t>, DOCUMENT_STATUS_COUNT> status_bitmaps_;
+    std::vector<int> free_slots_;
+    // Serializes status changes, each of which updates two bitmaps
+    std::mutex status_mutex_;
+};
@@ -0,0 +1,241 @@
+#include "document_loader.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+#include "bounded_queue.h"
+#include "field_parsing.h"
+
+using namespace std;
+
+namespace {
+
+// Whole lines of the input and the documents parsed from them,
+// passed through the pipeline by pointer so the views into text stay valid
+struct Batch {
+    string text;
+    size_t line_count = 0;
+
+    struct Record {
+        size_t line_number;
+        int document_id;
+        DocumentStatus status;
+        vector<int> ratings;
+        string_view text;
+        SearchServer::WordFrequencies word_freqs;
+        // The text has an invalid word; AddDocument reports it after checking the id
+        bool has_invalid_words;
+    };
+    vector<Record> records;
+    vector<LoadError> errors;
+};
+
+using BatchQueue = BoundedQueue<unique_ptr<Batch>>;
+
+string_view NextField(string_view& line) {
+    const size_t tab = line.find('\t');
+    if (tab == line.npos) {
+        throw invalid_argument("Expected 4 tab-separated fields"s);
+    }
+    const string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+Batch::Record ParseRecord(const SearchServer& search_server, string_view line, size_t line_number) {
+    const int document_id = ParseInt(NextField(line));
+    const DocumentStatus status = ParseStatus(NextField(line));
+    vector<int> ratings = ParseRatings(NextField(line));
+    SearchServer::WordFrequencies word_freqs;
+    bool has_invalid_words = false;
+    try {
+        word_freqs = search_server.ComputeWordFrequencies(line);
+    }
+    catch (const invalid_argument&) {
+        has_invalid_words = true;
+    }
+    return { line_number, document_id, status, move(ratings), line, move(word_freqs), has_invalid_words };
+}
+
+void ParseBatch(const SearchServer& search_server, Batch& batch, size_t& line_number) {
+    string_view text = batch.text;
+    while (!text.empty()) {
+        const size_t newline = text.find('\n');
+        string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == text.npos ? text.size() : newline + 1);
+        ++line_number;
+        ++batch.line_count;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            batch.records.push_back(ParseRecord(search_server, line, line_number));
+        }
+        catch (const invalid_argument& e) {
+            batch.errors.push_back({ line_number, e.what() });
+        }
+    }
+}
+
+// Cuts the input into chunks of whole lines; a line longer than a chunk is read on until its end
+void ReadChunks(istream& input, size_t chunk_size, BatchQueue& chunks) {
+    streambuf* buffer = input.rdbuf();
+    if (buffer == nullptr) {
+        return;
+    }
+    chunk_size = max<size_t>(chunk_size, 1);
+    string rest;
+    while (true) {
+        auto batch = make_unique<Batch>();
+        batch->text.swap(rest);
+        const size_t offset = batch->text.size();
+        batch->text.resize(offset + chunk_size);
+        const size_t count = static_cast<size_t>(buffer->sgetn(batch->text.data() + offset, chunk_size));
+        batch->text.resize(offset + count);
+        if (count == 0) {
+            if (!batch->text.empty()) {
+                chunks.Push(move(batch));
+            }
+            return;
+        }
+
+        const size_t last_newline = batch->text.rfind('\n');
+        if (last_newline == batch->text.npos) {
+            rest.swap(batch->text);
+            continue;
+        }
+        rest.assign(batch->text, last_newline + 1);
+        batch->text.resize(last_newline + 1);
+        if (!chunks.Push(move(batch))) {
+            return;
+        }
+    }
+}
+
+// Keeps the report sorted by line: the errors of a batch are merged before they are appended
+void AddErrors(LoadReport& report, vector<LoadError>& parse_errors, vector<LoadError>& index_errors, size_t max_reported_errors) {
+    report.error_count += parse_errors.size() + index_errors.size();
+    vector<LoadError> errors;
+    errors.reserve(parse_errors.size() + index_errors.size());
+    merge(make_move_iterator(parse_errors.begin()), make_move_iterator(parse_errors.end()),
+        make_move_iterator(index_errors.begin()), make_move_iterator(index_errors.end()),
+        back_inserter(errors),
+        [](const LoadError& lhs, const LoadError& rhs) {
+            return lhs.line_number < rhs.line_number;
+        });
+    for (LoadError& error : errors) {
+        if (report.errors.size() >= max_reported_errors) {
+            break;
+        }
+        report.errors.push_back(move(error));
+    }
+}
+
+}  // namespace
+
+LoadReport LoadDocuments(SearchServer& search_server, istream& input, const DocumentLoaderOptions& options) {
+    TraceSpan span("LoadDocuments"sv);
+    BatchQueue chunks(options.queue_capacity);
+    BatchQueue batches(options.queue_capacity);
+    exception_ptr reader_error;
+    exception_ptr parser_error;
+
+    thread reader([&] {
+        try {
+            ReadChunks(input, options.chunk_size, chunks);
+        }
+        catch (...) {
+            reader_error = current_exception();
+        }
+        chunks.Close();
+        });
+    thread parser([&] {
+        try {
+            size_t line_number = 0;
+            unique_ptr<Batch> batch;
+            while (chunks.Pop(batch)) {
+                ParseBatch(search_server, *batch, line_number);
+                if (!batches.Push(move(batch))) {
+                    break;
+                }
+            }
+        }
+        catch (...) {
+            parser_error = current_exception();
+            chunks.Close();
+        }
+        batches.Close();
+        });
+
+    LoadReport report;
+    try {
+        size_t next_progress = options.progress_interval;
+        unique_ptr<Batch> batch;
+        while (batches.Pop(batch)) {
+            vector<LoadError> index_errors;
+            for (Batch::Record& record : batch->records) {
+                try {
+                    if (record.has_invalid_words) {
+                        search_server.AddDocument(record.document_id, record.text, record.status, record.ratings);
+                    }
+                    else {
+                        search_server.AddDocument(record.document_id, record.text, record.status, record.ratings, move(record.word_freqs));
+                    }
+                    ++report.document_count;
+                }
+                catch (const invalid_argument& e) {
+                    index_errors.push_back({ record.line_number, e.what() });
+                }
+            }
+            AddErrors(report, batch->errors, index_errors, options.max_reported_errors);
+            report.bytes_read += batch->text.size();
+            report.line_count += batch->line_count;
+            if (options.on_progress && report.line_count >= next_progress) {
+                options.on_progress(report);
+                next_progress = report.line_count + options.progress_interval;
+            }
+        }
+    }
+    catch (...) {
+        chunks.Close();
+        batches.Close();
+        reader.join();
+        parser.join();
+        throw;
+    }
+    reader.join();
+    parser.join();
+    if (reader_error) {
+        rethrow_exception(reader_error);
+    }
+    if (parser_error) {
+        rethrow_exception(parser_error);
+    }
+
+    span.AddArg("documents"sv, report.document_count);
+    span.AddArg("errors"sv, report.error_count);
+    if (options.on_progress) {
+        options.on_progress(report);
+    }
+    return report;
+}
+
+LoadReport LoadDocumentsFromFile(SearchServer& search_server, const string& path, const DocumentLoaderOptions& options) {
+    if (path == "-"s) {
+        return LoadDocuments(search_server, cin, options);
+    }
+    ifstream input(path, ios::binary);
+    if (!input) {
+        throw runtime_error("Can't open "s + path);
+    }
+    return LoadDocuments(search_server, input, options);
+}
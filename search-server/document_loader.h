@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+struct LoadError {
+    size_t line_number = 0;
+    std::string message;
+};
+
+struct LoadReport {
+    size_t bytes_read = 0;
+    size_t line_count = 0;
+    size_t document_count = 0;
+    size_t error_count = 0;
+    // The first DocumentLoaderOptions::max_reported_errors errors by line number
+    std::vector<LoadError> errors;
+};
+
+struct DocumentLoaderOptions {
+    // Bytes taken from the input by one read
+    size_t chunk_size = 1 << 20;
+    // Chunks in flight between two stages
+    size_t queue_capacity = 4;
+    size_t max_reported_errors = 100;
+    // on_progress is called after every progress_interval lines and once at the end
+    size_t progress_interval = 100000;
+    std::function<void(const LoadReport&)> on_progress;
+};
+
+// Loads documents from tab-separated lines:
+//
+//   <id> \t <status> \t <rating,...> \t <text>
+//
+// where status is a number or a name (ACTUAL, IRRELEVANT, BANNED, REMOVED),
+// ratings may be empty or "-", and the text runs to the end of the line.
+// Empty lines are skipped. A line that can't be parsed or added is recorded
+// in the report and the load goes on.
+//
+// The input is read in large chunks by one thread, and another one splits it
+// into records and the texts into words (SearchServer::ComputeWordFrequencies),
+// while the calling thread adds the documents; bounded queues between
+// the stages keep the reader from running ahead of the index.
+LoadReport LoadDocuments(SearchServer& search_server, std::istream& input, const DocumentLoaderOptions& options = {});
+
+// Path "-" reads the standard input
+LoadReport LoadDocumentsFromFile(SearchServer& search_server, const std::string& path, const DocumentLoaderOptions& options = {});
@@ -0,0 +1,87 @@
+#include "document_store.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "lz_codec.h"
+
+using namespace std;
+
+DocumentStore::DocumentStore(const string& path, const DocumentStoreOptions& options)
+    : path_(path)
+    , options_(options)
+    , file_(path, ios::in | ios::out | ios::binary | ios::trunc) {
+    if (!file_) {
+        throw runtime_error("Can't open "s + path);
+    }
+    open_block_.reserve(options_.block_size);
+}
+
+DocumentStore::Location DocumentStore::Add(string_view text) {
+    lock_guard lock(mutex_);
+    if (!open_block_.empty() && open_block_.size() + text.size() > options_.block_size) {
+        Flush();
+    }
+    const Location location{ static_cast<uint32_t>(blocks_.size()), static_cast<uint32_t>(open_block_.size()), static_cast<uint32_t>(text.size()) };
+    open_block_.append(text);
+    return location;
+}
+
+string DocumentStore::Get(const Location& location) const {
+    lock_guard lock(mutex_);
+    const string& block = location.block == blocks_.size() ? open_block_ : GetBlock(location.block);
+    return block.substr(location.offset, location.size);
+}
+
+size_t DocumentStore::GetMemoryUsage() const {
+    lock_guard lock(mutex_);
+    size_t usage = blocks_.capacity() * sizeof(Block) + open_block_.capacity();
+    for (const auto& [block, text] : cache_) {
+        usage += 4 * sizeof(void*) + text.capacity();
+    }
+    return usage;
+}
+
+size_t DocumentStore::GetFileSize() const {
+    lock_guard lock(mutex_);
+    return file_size_;
+}
+
+void DocumentStore::Flush() {
+    string compressed = CompressLz(open_block_);
+    const bool is_compressed = compressed.size() < open_block_.size();
+    const string& stored = is_compressed ? compressed : open_block_;
+    file_.seekp(file_size_);
+    file_.write(stored.data(), stored.size());
+    if (!file_) {
+        // The block stays open, so the next Add tries to write it again
+        file_.clear();
+        throw runtime_error("Can't write "s + path_);
+    }
+    blocks_.push_back({ file_size_, static_cast<uint32_t>(stored.size()), static_cast<uint32_t>(open_block_.size()), is_compressed });
+    file_size_ += stored.size();
+    open_block_.clear();
+}
+
+const string& DocumentStore::GetBlock(uint32_t block) const {
+    const auto cached = find_if(cache_.begin(), cache_.end(), [block](const auto& entry) {
+        return entry.first == block;
+        });
+    if (cached != cache_.end()) {
+        cache_.splice(cache_.begin(), cache_, cached);
+        return cache_.front().second;
+    }
+
+    const Block& info = blocks_.at(block);
+    string stored(info.stored_size, '\0');
+    file_.seekg(info.file_offset);
+    file_.read(stored.data(), stored.size());
+    if (!file_) {
+        throw runtime_error("Can't read "s + path_);
+    }
+    if (cache_.size() >= max<size_t>(options_.cache_block_count, 1)) {
+        cache_.pop_back();
+    }
+    cache_.emplace_front(block, info.is_compressed ? DecompressLz(stored, info.size) : move(stored));
+    return cache_.front().second;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct DocumentStoreOptions {
+    // Bytes of text compressed together; a longer document gets a block of its own
+    size_t block_size = 64 << 10;
+    // Decompressed blocks kept in memory
+    size_t cache_block_count = 16;
+};
+
+// Append-only file of document texts. The texts are packed into blocks that
+// are compressed with CompressLz (or stored as is if that does not make them
+// smaller), and only the block table, the block being filled and a few recently
+// read blocks stay in memory. The file is created anew and is not compacted:
+// a removed document keeps its place in its block.
+// All methods may be called from several threads.
+class DocumentStore {
+public:
+    // Where the text of a document is in the store
+    struct Location {
+        uint32_t block = 0;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    explicit DocumentStore(const std::string& path, const DocumentStoreOptions& options = {});
+
+    Location Add(std::string_view text);
+
+    std::string Get(const Location& location) const;
+
+    // Heap usage of the block table, the block being filled and the cache, in bytes
+    size_t GetMemoryUsage() const;
+
+    size_t GetFileSize() const;
+
+private:
+    struct Block {
+        uint64_t file_offset;
+        uint32_t stored_size;
+        uint32_t size;
+        bool is_compressed;
+    };
+
+    // Compresses the block being filled and appends it to the file
+    void Flush();
+
+    const std::string& GetBlock(uint32_t block) const;
+
+    const std::string path_;
+    const DocumentStoreOptions options_;
+    mutable std::mutex mutex_;
+    mutable std::fstream file_;
+    std::vector<Block> blocks_;
+    uint64_t file_size_ = 0;
+    std::string open_block_;
+    // Most recently used first
+    mutable std::list<std::pair<uint32_t, std::string>> cache_;
+};
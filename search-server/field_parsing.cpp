@@ -0,0 +1,46 @@
+#include "field_parsing.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "document_attributes.h"
+
+using namespace std;
+
+int ParseInt(string_view text) {
+    int value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != errc() || end != text.data() + text.size()) {
+        throw invalid_argument("Invalid number "s + string(text));
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(string_view text) {
+    static const string_view STATUS_NAMES[DOCUMENT_STATUS_COUNT] = { "ACTUAL"sv, "IRRELEVANT"sv, "BANNED"sv, "REMOVED"sv };
+    const auto name = find(begin(STATUS_NAMES), end(STATUS_NAMES), text);
+    if (name != end(STATUS_NAMES)) {
+        return static_cast<DocumentStatus>(name - begin(STATUS_NAMES));
+    }
+    const int status = text.empty() || text[0] == '-' ? -1 : ParseInt(text);
+    if (status < 0 || status >= DOCUMENT_STATUS_COUNT) {
+        throw invalid_argument("Invalid status "s + string(text));
+    }
+    return static_cast<DocumentStatus>(status);
+}
+
+vector<int> ParseRatings(string_view text) {
+    vector<int> ratings;
+    if (text == "-"sv) {
+        return ratings;
+    }
+    while (!text.empty()) {
+        const size_t comma = text.find(',');
+        ratings.push_back(ParseInt(text.substr(0, comma)));
+        text.remove_prefix(comma == text.npos ? text.size() : comma + 1);
+    }
+    return ratings;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// Fields of the text formats that carry documents: the lines of LoadDocuments
+// and the ADD request of QueryServer. Malformed text throws std::invalid_argument.
+
+// Decimal int that takes the whole text
+int ParseInt(std::string_view text);
+
+// A number or a name: ACTUAL, IRRELEVANT, BANNED, REMOVED
+DocumentStatus ParseStatus(std::string_view text);
+
+// Comma-separated ints; empty text or "-" is no ratings
+std::vector<int> ParseRatings(std::string_view text);
@@ -0,0 +1,220 @@
+#include "impact_index.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+#ifdef __AVX2__
+inline __m256 LoadImpacts(const float* impacts, float) {
+    return _mm256_loadu_ps(impacts);
+}
+
+inline __m256 LoadImpacts(const uint16_t* impacts, float scale) {
+    const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(impacts));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(packed)), _mm256_set1_ps(scale));
+}
+
+inline __m256 LoadImpacts(const uint8_t* impacts, float scale) {
+    const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(impacts));
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(packed)), _mm256_set1_ps(scale));
+}
+#endif
+
+inline float Dequantize(float impact, float) {
+    return impact;
+}
+
+template <typename Quantized>
+inline float Dequantize(Quantized impact, float scale) {
+    return static_cast<float>(impact) * scale;
+}
+
+// scores[slots[i]] += impacts[i] * scale. Slots of one posting list are unique,
+// so the eight gathered lanes can be written back independently.
+template <typename Impact>
+void AddImpacts(const int32_t* slots, const Impact* impacts, size_t count, float scale,
+    float* scores, uint8_t* matched) {
+    size_t i = 0;
+#ifdef __AVX2__
+    alignas(32) float sums[8];
+    for (; i + 8 <= count; i += 8) {
+        const __m256i indexes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(slots + i));
+        const __m256 current = _mm256_i32gather_ps(scores, indexes, sizeof(float));
+        _mm256_store_ps(sums, _mm256_add_ps(current, LoadImpacts(impacts + i, scale)));
+        for (size_t lane = 0; lane < 8; ++lane) {
+            scores[slots[i + lane]] = sums[lane];
+            matched[slots[i + lane]] = 1;
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        scores[slots[i]] += Dequantize(impacts[i], scale);
+        matched[slots[i]] = 1;
+    }
+}
+
+}  // namespace
+
+ImpactIndex::ImpactIndex(const SearchServer& search_server, ImpactPrecision precision)
+    : search_server_(search_server)
+    , precision_(precision)
+    , index_version_(search_server.GetIndexVersion()) {
+    slot_ids_.reserve(search_server.documents_.size());
+    attribute_slots_.reserve(search_server.documents_.size());
+    for (const auto& [document_id, document_data] : search_server.documents_) {
+        slot_ids_.push_back(document_id);
+        attribute_slots_.push_back(document_data.slot);
+    }
+
+    for (const auto& [word, postings] : search_server.word_to_document_freqs_) {
+        if (postings.empty()) {
+            continue;
+        }
+        const double inverse_document_freq = search_server.ComputeInverseDocumentFreq(word, postings.size());
+        TermImpacts& term = terms_[string(word)];
+        term.slots.reserve(postings.size());
+        vector<double> impacts;
+        impacts.reserve(postings.size());
+        auto slot = slot_ids_.begin();
+        for (const auto& [document_id, posting] : postings) {
+            slot = lower_bound(slot, slot_ids_.end(), document_id);
+            term.slots.push_back(static_cast<int32_t>(slot - slot_ids_.begin()));
+            impacts.push_back(posting.term_freq * inverse_document_freq);
+            term.max_impact = max(term.max_impact, impacts.back());
+        }
+
+        if (precision_ == ImpactPrecision::FLOAT32) {
+            term.impacts.assign(impacts.begin(), impacts.end());
+            term.max_error = term.max_impact * FLT_EPSILON;
+            continue;
+        }
+        const double max_value = precision_ == ImpactPrecision::UINT16
+            ? numeric_limits<uint16_t>::max() : numeric_limits<uint8_t>::max();
+        term.scale = term.max_impact > 0.0 ? static_cast<float>(term.max_impact / max_value) : 1.0f;
+        term.max_error = term.scale * 0.5 + term.max_impact * FLT_EPSILON;
+        for (double impact : impacts) {
+            const double quantized = round(impact / term.scale);
+            if (precision_ == ImpactPrecision::UINT16) {
+                term.impacts16.push_back(static_cast<uint16_t>(min(quantized, max_value)));
+            }
+            else {
+                term.impacts8.push_back(static_cast<uint8_t>(min(quantized, max_value)));
+            }
+        }
+    }
+}
+
+vector<Document> ImpactIndex::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, StatusFilter{ status });
+}
+
+vector<Document> ImpactIndex::FindTopDocuments(string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+ImpactPrecision ImpactIndex::GetPrecision() const {
+    return precision_;
+}
+
+bool ImpactIndex::IsUpToDate() const {
+    return index_version_ == search_server_.GetIndexVersion();
+}
+
+size_t ImpactIndex::GetMemoryUsage() const {
+    size_t usage = (slot_ids_.capacity() + attribute_slots_.capacity()) * sizeof(int);
+    for (const auto& [word, term] : terms_) {
+        usage += 4 * sizeof(void*) + sizeof(pair<const string, TermImpacts>)
+            + term.slots.capacity() * sizeof(int32_t)
+            + term.impacts.capacity() * sizeof(float)
+            + term.impacts16.capacity() * sizeof(uint16_t)
+            + term.impacts8.capacity() * sizeof(uint8_t);
+    }
+    return usage;
+}
+
+double ImpactIndex::Accumulate(const vector<string_view>& plus_words, vector<float>& scores, vector<uint8_t>& matched) const {
+    double max_error = 0.0;
+    double max_score = 0.0;
+    for (string_view word : plus_words) {
+        const auto it = terms_.find(word);
+        if (it == terms_.end()) {
+            continue;
+        }
+        const TermImpacts& term = it->second;
+        switch (precision_) {
+        case ImpactPrecision::FLOAT32:
+            AddImpacts(term.slots.data(), term.impacts.data(), term.slots.size(), term.scale, scores.data(), matched.data());
+            break;
+        case ImpactPrecision::UINT16:
+            AddImpacts(term.slots.data(), term.impacts16.data(), term.slots.size(), term.scale, scores.data(), matched.data());
+            break;
+        case ImpactPrecision::UINT8:
+            AddImpacts(term.slots.data(), term.impacts8.data(), term.slots.size(), term.scale, scores.data(), matched.data());
+            break;
+        }
+        max_error += term.max_error;
+        max_score += term.max_impact;
+    }
+    // Every float addition may round the partial sum once more
+    return max_error + (plus_words.size() + 1) * FLT_EPSILON * max_score;
+}
+
+void ImpactIndex::Exclude(const vector<string_view>& minus_words, vector<uint8_t>& matched) const {
+    for (string_view word : minus_words) {
+        const auto it = terms_.find(word);
+        if (it == terms_.end()) {
+            continue;
+        }
+        for (int32_t slot : it->second.slots) {
+            matched[slot] = 0;
+        }
+    }
+}
+
+vector<Document> ImpactIndex::SelectTopDocuments(const vector<string_view>& plus_words,
+    const vector<float>& scores, vector<int>& candidates, double max_error) const {
+    if (candidates.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        // Anything that may still reach the top after exact rescoring: the approximate
+        // score error plus the EPSILON window in which ratings decide the order
+        const auto by_score = [&scores](int lhs, int rhs) {
+            return scores[lhs] > scores[rhs];
+        };
+        nth_element(candidates.begin(), candidates.begin() + (MAX_RESULT_DOCUMENT_COUNT - 1), candidates.end(), by_score);
+        const double threshold = scores[candidates[MAX_RESULT_DOCUMENT_COUNT - 1]] - 2 * max_error - EPSILON;
+        candidates.erase(
+            remove_if(candidates.begin(), candidates.end(), [&scores, threshold](int slot) {
+                return scores[slot] < threshold;
+                }),
+            candidates.end());
+    }
+
+    vector<Document> matched_documents;
+    matched_documents.reserve(candidates.size());
+    for (int slot : candidates) {
+        // Same order of additions as SearchServer::FindAllDocuments, so the sums are bitwise equal
+        const auto& word_freqs = search_server_.GetWordFrequencies(slot_ids_[slot]);
+        double relevance = 0.0;
+        for (string_view word : plus_words) {
+            const auto it = SearchServer::FindWordOrNext(word_freqs, word);
+            if (it != word_freqs.end() && it->first == word) {
+                relevance += it->second * search_server_.ComputeWordInverseDocumentFreq(word);
+            }
+        }
+        matched_documents.push_back({ slot_ids_[slot], relevance, search_server_.attributes_.GetRating(attribute_slots_[slot]) });
+    }
+
+    sort(matched_documents.begin(), matched_documents.end(), IsMoreRelevant);
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return matched_documents;
+}
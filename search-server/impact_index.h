@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+enum class ImpactPrecision {
+    FLOAT32,
+    UINT16,
+    UINT8,
+};
+
+// Read-only scoring engine built from the postings of a SearchServer.
+// Each posting stores its impact (tf * idf) precomputed as a float or as a
+// quantized 16/8-bit value. Queries accumulate impacts into a dense float
+// array with AVX2 gather/add kernels when the build enables AVX2.
+//
+// Results are identical to SearchServer::FindTopDocuments: every document
+// whose approximate score is within the error bound plus EPSILON of the
+// K-th best one is rescored in double precision before the final ranking.
+// Queries with prefix or required words are delegated to the server.
+//
+// Statuses and ratings are read from the attribute columns of the server, so
+// SetDocumentStatus and SetDocumentRating are seen at once, like in the server.
+// Once the server adds or removes a document, the impacts are out of date and
+// every query goes to the server instead, until a new index is built.
+class ImpactIndex {
+public:
+    explicit ImpactIndex(const SearchServer& search_server, ImpactPrecision precision = ImpactPrecision::FLOAT32);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    ImpactPrecision GetPrecision() const;
+
+    // False once the server has added or removed documents since the index was built
+    bool IsUpToDate() const;
+
+    size_t GetMemoryUsage() const;
+
+private:
+    struct TermImpacts {
+        std::vector<int32_t> slots;
+        std::vector<float> impacts;
+        std::vector<uint16_t> impacts16;
+        std::vector<uint8_t> impacts8;
+        // impact = quantized value * scale
+        float scale = 1.0f;
+        double max_impact = 0.0;
+        // Largest difference between a stored impact and the exact one
+        double max_error = 0.0;
+    };
+
+    // Adds the impacts of plus words to scores and marks the documents they contain;
+    // returns the bound of the accumulated error
+    double Accumulate(const std::vector<std::string_view>& plus_words,
+        std::vector<float>& scores, std::vector<uint8_t>& matched) const;
+
+    void Exclude(const std::vector<std::string_view>& minus_words, std::vector<uint8_t>& matched) const;
+
+    std::vector<Document> SelectTopDocuments(const std::vector<std::string_view>& plus_words,
+        const std::vector<float>& scores, std::vector<int>& candidates, double max_error) const;
+
+    const SearchServer& search_server_;
+    ImpactPrecision precision_;
+    size_t index_version_;
+    // The words are copied, so the snapshot does not point into the vocabulary of the server
+    std::map<std::string, TermImpacts, std::less<>> terms_;
+    std::vector<int> slot_ids_;
+    // Slot of each document in the attributes of the server
+    std::vector<int> attribute_slots_;
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> ImpactIndex::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    if (!IsUpToDate()) {
+        return search_server_.FindTopDocuments(raw_query, document_predicate);
+    }
+    const auto query = search_server_.ParseQuery(raw_query);
+    if (!query.plus_prefixes.empty() || !query.minus_prefixes.empty() || !query.required_words.empty()) {
+        return search_server_.FindTopDocuments(raw_query, document_predicate);
+    }
+
+    std::vector<float> scores(slot_ids_.size());
+    std::vector<uint8_t> matched(slot_ids_.size());
+    const double max_error = Accumulate(query.plus_words, scores, matched);
+    Exclude(query.minus_words, matched);
+
+    std::vector<int> candidates;
+    for (size_t slot = 0; slot < matched.size(); ++slot) {
+        if (matched[slot] && search_server_.IsAccepted(document_predicate, slot_ids_[slot], attribute_slots_[slot])) {
+            candidates.push_back(static_cast<int>(slot));
+        }
+    }
+    return SelectTopDocuments(query.plus_words, scores, candidates, max_error);
+}
@@ -2,7 +2,8 @@
 
 LogDuration::LogDuration(std::string_view id, std::ostream& dst_stream)
     : id_(id)
-    , dst_stream_(dst_stream) {
+    , dst_stream_(dst_stream)
+    , trace_span_(id) {
 }
 
 LogDuration::~LogDuration() {
@@ -12,4 +13,4 @@ LogDuration::~LogDuration() {
     const auto end_time = Clock::now();
     const auto dur = end_time - start_time_;
     dst_stream_ << id_ << ": "sv << duration_cast<milliseconds>(dur).count() << " ms"sv << std::endl;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <string_view>
 
+#include "trace.h"
+
 #define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
 #define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
 #define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
@@ -46,6 +48,21 @@
  */
 #define LOG_DURATION_STREAM(x, y) LogDuration UNIQUE_VAR_NAME_PROFILE(x, y)
 
+/**
+ * Записывает интервал от своего вызова до конца текущего блока
+ * в трассировку (см. trace.h), ничего не выводя в поток.
+ * LOG_DURATION и LOG_DURATION_STREAM тоже попадают в трассировку,
+ * если она включена через Tracer::Instance().Enable().
+ *
+ * Пример использования:
+ *
+ *  void ProcessBatch() {
+ *      LOG_TRACE("ProcessBatch"sv);
+ *      ...
+ *  }
+ */
+#define LOG_TRACE(x) TraceSpan UNIQUE_VAR_NAME_PROFILE(x)
+
 class LogDuration {
 public:
     // заменим имя типа std::chrono::steady_clock
@@ -61,4 +78,5 @@ private:
     const std::string id_;
     const Clock::time_point start_time_ = Clock::now();
     std::ostream& dst_stream_;
+    TraceSpan trace_span_;
 };
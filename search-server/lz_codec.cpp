@@ -0,0 +1,139 @@
+#include "lz_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 0xFFFF;
+const int HASH_BITS = 14;
+const size_t LENGTH_MASK = 15;
+
+uint32_t Read32(string_view data, size_t position) {
+    uint32_t value;
+    memcpy(&value, data.data() + position, sizeof(value));
+    return value;
+}
+
+size_t HashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// The part of a length that does not fit in its 4 bits of the token
+void WriteLengthTail(string& output, size_t length) {
+    if (length < LENGTH_MASK) {
+        return;
+    }
+    length -= LENGTH_MASK;
+    while (length >= 255) {
+        output.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+void WriteSequence(string& output, string_view literals, size_t offset, size_t match_length) {
+    const size_t match_code = match_length - MIN_MATCH;
+    output.push_back(static_cast<char>((min(literals.size(), LENGTH_MASK) << 4) | min(match_code, LENGTH_MASK)));
+    WriteLengthTail(output, literals.size());
+    output.append(literals);
+    output.push_back(static_cast<char>(offset & 0xFF));
+    output.push_back(static_cast<char>(offset >> 8));
+    WriteLengthTail(output, match_code);
+}
+
+size_t ReadLength(string_view data, size_t& position, size_t length) {
+    if (length < LENGTH_MASK) {
+        return length;
+    }
+    while (true) {
+        if (position == data.size()) {
+            throw runtime_error("Compressed data is truncated"s);
+        }
+        const auto byte = static_cast<unsigned char>(data[position++]);
+        length += byte;
+        if (byte != 255) {
+            return length;
+        }
+    }
+}
+
+}  // namespace
+
+string CompressLz(string_view data) {
+    string output;
+    output.reserve(data.size() / 2 + 16);
+    // Position plus one of the last sequence with each hash, 0 if none
+    vector<uint32_t> last_positions(size_t{ 1 } << HASH_BITS, 0);
+
+    size_t literal_begin = 0;
+    size_t position = 0;
+    while (position + MIN_MATCH <= data.size()) {
+        const uint32_t sequence = Read32(data, position);
+        uint32_t& last_position = last_positions[HashSequence(sequence)];
+        const size_t candidate = last_position;
+        last_position = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || Read32(data, candidate - 1) != sequence) {
+            ++position;
+            continue;
+        }
+
+        const size_t match = candidate - 1;
+        size_t match_length = MIN_MATCH;
+        while (position + match_length < data.size() && data[match + match_length] == data[position + match_length]) {
+            ++match_length;
+        }
+        WriteSequence(output, data.substr(literal_begin, position - literal_begin), position - match, match_length);
+        position += match_length;
+        literal_begin = position;
+    }
+
+    const string_view literals = data.substr(literal_begin);
+    output.push_back(static_cast<char>(min(literals.size(), LENGTH_MASK) << 4));
+    WriteLengthTail(output, literals.size());
+    output.append(literals);
+    return output;
+}
+
+string DecompressLz(string_view data, size_t decompressed_size) {
+    string output;
+    output.reserve(decompressed_size);
+    size_t position = 0;
+    while (position < data.size()) {
+        const auto token = static_cast<unsigned char>(data[position++]);
+        const size_t literal_length = ReadLength(data, position, token >> 4);
+        if (literal_length > data.size() - position || literal_length > decompressed_size - output.size()) {
+            throw runtime_error("Compressed data is corrupted"s);
+        }
+        output.append(data.substr(position, literal_length));
+        position += literal_length;
+        if (position == data.size()) {
+            break;
+        }
+
+        if (data.size() - position < 2) {
+            throw runtime_error("Compressed data is truncated"s);
+        }
+        const size_t offset = static_cast<unsigned char>(data[position]) | (static_cast<unsigned char>(data[position + 1]) << 8);
+        position += 2;
+        const size_t match_length = ReadLength(data, position, token & LENGTH_MASK) + MIN_MATCH;
+        if (offset == 0 || offset > output.size() || match_length > decompressed_size - output.size()) {
+            throw runtime_error("Compressed data is corrupted"s);
+        }
+        // The match may overlap the bytes it produces, so it is copied byte by byte
+        const size_t match = output.size() - offset;
+        for (size_t i = 0; i < match_length; ++i) {
+            output.push_back(output[match + i]);
+        }
+    }
+    if (output.size() != decompressed_size) {
+        throw runtime_error("Compressed data is corrupted"s);
+    }
+    return output;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Byte-oriented LZ77 in the manner of LZ4: a sequence is a token with the
+// lengths of its literals and its match, the literals, and a 2-byte offset
+// of the match back into the output. The last sequence has literals only.
+// Fast to decode and good enough for natural-language text.
+std::string CompressLz(std::string_view data);
+
+// Throws std::runtime_error if data is not CompressLz output of decompressed_size bytes
+std::string DecompressLz(std::string_view data, size_t decompressed_size);
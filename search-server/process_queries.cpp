@@ -3,27 +3,64 @@
 #include <algorithm>
 #include <execution>
 
+#include "log_duration.h"
+
 using namespace std;
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries) {
+    const std::vector<std::string>& queries,
+    BatchMode mode) {
 
+    LOG_TRACE("ProcessQueries"sv);
+    if (mode == BatchMode::SHARED) {
+        return search_server.FindTopDocumentsBatch(queries);
+    }
     std::vector<std::vector<Document>> res(queries.size());
 
     std::transform(std::execution::par, queries.cbegin(), queries.cend(), res.begin(), [&search_server](const std::string& query)
-        { return move(search_server.FindTopDocuments(query)); });
+        {
+            TraceSpan span("ProcessQueries.query"sv);
+            span.AddArg("query"sv, query);
+            auto documents = search_server.FindTopDocuments(query);
+            span.AddArg("results"sv, documents.size());
+            return documents;
+        });
+
+    return res;
+}
+
+std::vector<SearchResult> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryBudget& budget) {
+
+    LOG_TRACE("ProcessQueries"sv);
+    std::vector<SearchResult> res(queries.size());
+
+    std::transform(std::execution::par, queries.cbegin(), queries.cend(), res.begin(), [&search_server, &budget](const std::string& query)
+        {
+            TraceSpan span("ProcessQueries.query"sv);
+            span.AddArg("query"sv, query);
+            auto result = search_server.FindTopDocuments(query, budget);
+            span.AddArg("results"sv, result.documents.size());
+            if (result.is_approximate) {
+                span.AddArg("approximate"sv, "true"sv);
+            }
+            return result;
+        });
 
     return res;
 }
 
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries) {
+    const std::vector<std::string>& queries,
+    BatchMode mode) {
 
     std::list<Document> result;
 
-    for (std::vector<Document>& vect : ProcessQueries(search_server, queries)) {
+    for (std::vector<Document>& vect : ProcessQueries(search_server, queries, mode)) {
         for (Document& g : vect) {
             result.push_back(g);
         }
@@ -7,10 +7,27 @@
 #include <string>
 #include <list>
 
+// PER_QUERY evaluates the queries in parallel, each on its own.
+// SHARED traverses the posting lists common to several queries once,
+// see SearchServer::FindTopDocumentsBatch; the results are the same.
+enum class BatchMode {
+    PER_QUERY,
+    SHARED,
+};
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
+    const std::vector<std::string>& queries,
+    BatchMode mode = BatchMode::PER_QUERY);
+
+// PER_QUERY evaluation with each query within the budget. max_postings limits
+// every query on its own, while the deadline is the same moment for all of them.
+std::vector<SearchResult> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    const QueryBudget& budget);
 
 std::list<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries);
+    const std::vector<std::string>& queries,
+    BatchMode mode = BatchMode::PER_QUERY);
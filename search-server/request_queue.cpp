@@ -1,31 +1,84 @@
 #include "request_queue.h" 
 
+#include <algorithm>
+#include <stdexcept>
+
 using namespace std;
 
-RequestQueue::RequestQueue(const SearchServer& search_server)
-    :queue_search_server(search_server) {}
+namespace {
+
+const uint64_t OCCUPIED_BIT = uint64_t{ 1 } << 63;
+const int RESULT_COUNT_SHIFT = 40;
+const uint64_t RESULT_COUNT_MASK = (uint64_t{ 1 } << 16) - 1;
+const uint64_t LATENCY_MASK = (uint64_t{ 1 } << RESULT_COUNT_SHIFT) - 1;
+
+struct RequestStats {
+    bool is_occupied;
+    int64_t result_count;
+    int64_t latency;
+};
+
+uint64_t Pack(size_t result_count, int64_t latency) {
+    return OCCUPIED_BIT
+        | (min<uint64_t>(result_count, RESULT_COUNT_MASK) << RESULT_COUNT_SHIFT)
+        | min<uint64_t>(max<int64_t>(latency, 0), LATENCY_MASK);
+}
+
+RequestStats Unpack(uint64_t slot) {
+    return {
+        (slot & OCCUPIED_BIT) != 0,
+        static_cast<int64_t>((slot >> RESULT_COUNT_SHIFT) & RESULT_COUNT_MASK),
+        static_cast<int64_t>(slot & LATENCY_MASK)
+    };
+}
+
+}  // namespace
+
+RequestQueue::RequestQueue(const SearchServer& search_server, size_t window_size)
+    : search_server_(search_server)
+    , window_size_(window_size)
+    , slots_(new atomic<uint64_t>[window_size]()) {
+    if (window_size == 0) {
+        throw invalid_argument("Window size must be positive"s);
+    }
+}
 
 vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    MoveDeque(queue_search_server.FindTopDocuments(raw_query, status));
-    return requests_.back().results_;
+    return AddFindRequest(raw_query, StatusFilter{ status });
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    int result = 0;
-    for (auto it : requests_) {
-        if (it.results_.empty()) {
-            ++result;
-        }
-    }
-    return result;
+    return static_cast<int>(no_result_count_.load(memory_order_relaxed));
 }
 
-void RequestQueue::MoveDeque(vector<Document> requests) {
-    if (requests_.size() == min_in_day_) {
-        requests_.pop_front();
-    }
-    requests_.push_back(requests);
+int RequestQueue::GetRequestCount() const {
+    return static_cast<int>(request_count_.load(memory_order_relaxed));
+}
+
+double RequestQueue::GetMeanResultCount() const {
+    const int64_t request_count = request_count_.load(memory_order_relaxed);
+    return request_count > 0 ? result_count_sum_.load(memory_order_relaxed) * 1.0 / request_count : 0.0;
+}
+
+chrono::duration<double, micro> RequestQueue::GetMeanLatency() const {
+    const int64_t request_count = request_count_.load(memory_order_relaxed);
+    return chrono::duration<double, micro>(
+        request_count > 0 ? latency_sum_.load(memory_order_relaxed) * 1.0 / request_count : 0.0);
+}
+
+size_t RequestQueue::GetWindowSize() const {
+    return window_size_;
+}
+
+void RequestQueue::AddRequestStats(size_t result_count, chrono::steady_clock::duration latency) {
+    const uint64_t packed = Pack(result_count, chrono::duration_cast<chrono::microseconds>(latency).count());
+    const uint64_t ticket = next_slot_.fetch_add(1, memory_order_relaxed);
+    // Each evicted value is returned to exactly one thread, which takes it out of the totals
+    const RequestStats added = Unpack(packed);
+    const RequestStats evicted = Unpack(slots_[ticket % window_size_].exchange(packed, memory_order_acq_rel));
+
+    request_count_.fetch_add(evicted.is_occupied ? 0 : 1, memory_order_relaxed);
+    no_result_count_.fetch_add((added.result_count == 0) - (evicted.is_occupied && evicted.result_count == 0), memory_order_relaxed);
+    result_count_sum_.fetch_add(added.result_count - evicted.result_count, memory_order_relaxed);
+    latency_sum_.fetch_add(added.latency - evicted.latency, memory_order_relaxed);
 }
-/*        9  ,   FindTopDocuments  .*/
-RequestQueue::QueryResult::QueryResult(vector<Document> request) 
-    :results_(request) {}
\ No newline at end of file
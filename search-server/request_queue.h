@@ -1,15 +1,24 @@
 #pragma once
-#include <vector> 
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 
 #include "search_server.h"
 #include "document.h"
 
+// Statistics of the last window_size requests. AddFindRequest may be called
+// from many threads at once: every request takes the next slot of a ring buffer
+// with an atomic ticket, swaps its packed statistics in, and applies the
+// difference with the evicted slot to running totals, so the getters are O(1).
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server);
+    static const size_t DEFAULT_WINDOW_SIZE = 1440;
+
+    explicit RequestQueue(const SearchServer& search_server, size_t window_size = DEFAULT_WINDOW_SIZE);
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
@@ -17,23 +26,34 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status = DocumentStatus::ACTUAL);
 
     int GetNoResultRequests() const;
-    
-private:
-    struct QueryResult {
-        QueryResult(std::vector<Document> request);
-        std::vector<Document> results_;
-    };   
-    
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
-    const SearchServer& queue_search_server;
-    void MoveDeque(std::vector<Document> requests); 
-    /*    , FindTopDocuments  */
 
+    // Requests in the window, at most the window size
+    int GetRequestCount() const;
+
+    double GetMeanResultCount() const;
+
+    std::chrono::duration<double, std::micro> GetMeanLatency() const;
+
+    size_t GetWindowSize() const;
+
+private:
+    void AddRequestStats(size_t result_count, std::chrono::steady_clock::duration latency);
+
+    const SearchServer& search_server_;
+    const size_t window_size_;
+    // Occupied flag, result count and latency in microseconds packed into one word
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    std::atomic<uint64_t> next_slot_{ 0 };
+    std::atomic<int64_t> request_count_{ 0 };
+    std::atomic<int64_t> no_result_count_{ 0 };
+    std::atomic<int64_t> result_count_sum_{ 0 };
+    std::atomic<int64_t> latency_sum_{ 0 };
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    MoveDeque(queue_search_server.FindTopDocuments(raw_query, document_predicate));
-    return requests_.back().results_;
-}
\ No newline at end of file
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<Document> results = search_server_.FindTopDocuments(raw_query, document_predicate);
+    AddRequestStats(results.size(), std::chrono::steady_clock::now() - start);
+    return results;
+}
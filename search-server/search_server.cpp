@@ -7,22 +7,102 @@ SearchServer::SearchServer(const string& stop_words_text)
     : SearchServer(SplitIntoWords(stop_words_text)) {
 }
 
+SearchServer::SearchServer(const SearchServer& other)
+    : stop_words_(other.stop_words_)
+    , words_(other.words_)
+    , documents_(other.documents_)
+    , document_ids_(other.document_ids_)
+    , attributes_(other.attributes_)
+    , corpus_statistics_(other.corpus_statistics_)
+    , document_store_(other.document_store_) {
+    // The views of the copy must point into its own words, which are in the same order
+    for (const auto& [word, postings] : other.word_to_document_freqs_) {
+        const string_view own_word = *words_.find(word);
+        word_to_document_freqs_.emplace_hint(word_to_document_freqs_.end(), own_word, postings);
+        max_term_freqs_.emplace_hint(max_term_freqs_.end(), own_word, other.max_term_freqs_.at(word));
+    }
+    for (auto& [document_id, document_data] : documents_) {
+        for (auto& [word, term_freq] : document_data.word_freqs) {
+            word = *words_.find(word);
+        }
+    }
+
+    // The payloads of the dictionary point into the index, so the copy builds its own
+    vector<pair<string_view, const InvertedIndex::value_type*>> terms;
+    terms.reserve(word_to_document_freqs_.size());
+    for (const auto& entry : word_to_document_freqs_) {
+        if (!entry.second.empty()) {
+            terms.push_back({ entry.first, &entry });
+        }
+    }
+    term_dictionary_.Build(terms);
+}
+
 void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status, string(document) });
+    AddDocument(document_id, document, status, ratings, ComputeWordFrequencies(document));
+}
+
+void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings, WordFrequencies word_freqs) {
+    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+        throw invalid_argument("Invalid document_id"s);
+    }
+    // Writing to the store may fail, so it comes before any change of the index
+    optional<DocumentStore::Location> stored_text;
+    if (document_store_) {
+        stored_text = document_store_->Add(document);
+    }
+    for (auto& [word, term_freq] : word_freqs) {
+        word = InternWord(word);
+    }
+
+    const int slot = attributes_.Add(document_id, status, ComputeAverageRating(ratings));
+    for (const auto& [word, term_freq] : word_freqs) {
+        auto& entry = *word_to_document_freqs_.try_emplace(word).first;
+        if (entry.second.empty()) {
+            term_dictionary_.Insert(word, &entry);
+        }
+        entry.second.emplace(document_id, Posting{ term_freq, slot });
+        double& max_term_freq = max_term_freqs_[word];
+        max_term_freq = max(max_term_freq, term_freq);
+    }
+    documents_.emplace(document_id, DocumentData{ slot, stored_text ? string() : string(document), stored_text, move(word_freqs) });
     document_ids_.insert(document_id);
-    auto words = SplitIntoWordsNoStop(documents_.at(document_id).data);
-    const double inv_word_count = 1.0 / words.size();
-    for (auto word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        document_to_words_freqs_[document_id][word] += inv_word_count;
+    ++index_version_;
+}
+
+void SearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        throw invalid_argument("Invalid document_id"s);
+    }
+    attributes_.SetStatus(it->second.slot, status);
+}
+
+void SearchServer::SetDocumentRating(int document_id, const vector<int>& ratings) {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        throw invalid_argument("Invalid document_id"s);
     }
+    attributes_.SetRating(it->second.slot, ComputeAverageRating(ratings));
+}
+
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, QueryMode mode) const {
+    return FindTopDocuments(execution::seq, raw_query, status, mode);
+}
+
+const vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, string_view raw_query, DocumentStatus status, QueryMode mode) const {
+    return FindTopDocuments(context, raw_query, StatusFilter{ status }, mode);
+}
+
+SearchResult SearchServer::FindTopDocuments(string_view raw_query, const QueryBudget& budget, DocumentStatus status, QueryMode mode) const {
+    return FindTopDocuments(raw_query, budget, StatusFilter{ status }, mode);
 }
 
-vector<Document> SearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(execution::seq, raw_query, status);
+vector<Document> SearchServer::FindTopDocuments(string_view raw_query, QueryMode mode) const {
+    return FindTopDocuments(execution::seq, raw_query, DocumentStatus::ACTUAL, mode);
 }
 
 vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
@@ -41,12 +121,13 @@ set<int>::iterator SearchServer::end() {
     return document_ids_.end();
 }
 
-const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static map<string_view, double> FreqsEmpty;
-    if (document_to_words_freqs_.count(document_id) == 0) {
+const SearchServer::WordFrequencies& SearchServer::GetWordFrequencies(int document_id) const {
+    static const WordFrequencies FreqsEmpty;
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
         return FreqsEmpty;
     }
-    return document_to_words_freqs_.find(document_id)->second;
+    return it->second.word_freqs;
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -58,19 +139,26 @@ void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int d
     if (check == document_ids_.cend()) {
         return;
     }
+    for (const auto& [RemoveData, Freqs] : documents_.at(document_id).word_freqs) {
+        const auto postings = word_to_document_freqs_.find(RemoveData);
+        postings->second.erase(document_id);
+        if (postings->second.empty()) {
+            EraseWord(postings);
+        }
+    }
+    attributes_.Remove(documents_.at(document_id).slot);
     documents_.erase(document_id);
     document_ids_.erase(check);
-    for (const auto& [RemoveData, Freqs] : document_to_words_freqs_[document_id]) {
-        word_to_document_freqs_[RemoveData].erase(document_id);
-    }
-    document_to_words_freqs_.erase(document_id);
+    ++index_version_;
 }
 
 void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
     if (!document_ids_.count(document_id)) return;
+    auto documents_remove = move(documents_.at(document_id).word_freqs);
+    attributes_.Remove(documents_.at(document_id).slot);
     documents_.erase(document_id);
     document_ids_.erase(document_id);
-    auto documents_remove = move(document_to_words_freqs_.at(document_id));
+    ++index_version_;
     vector <string_view> tmp(documents_remove.size());
     transform(execution::par, documents_remove.begin(), documents_remove.end(), tmp.begin(),
         [](auto f) {
@@ -80,6 +168,12 @@ void SearchServer::RemoveDocument(const execution::parallel_policy&, int documen
         [this, document_id](auto word) {
             word_to_document_freqs_.at(word).erase(document_id);
             return; });
+    for (auto word : tmp) {
+        const auto postings = word_to_document_freqs_.find(word);
+        if (postings->second.empty()) {
+            EraseWord(postings);
+        }
+    }
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
@@ -97,7 +191,27 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
             continue;
         }
         if (word_to_document_freqs_.at(word).count(document_id)) {
-            return { matched_words, documents_.at(document_id).status };
+            return { matched_words, attributes_.GetStatus(documents_.at(document_id).slot) };
+        }
+    }
+    for (auto word : query.required_words) {
+        if (!HasWord(GetWordFrequencies(document_id), word)) {
+            return { matched_words, attributes_.GetStatus(documents_.at(document_id).slot) };
+        }
+    }
+    if (!query.minus_prefixes.empty() || !query.plus_prefixes.empty()) {
+        const auto& document_words = GetWordFrequencies(document_id);
+        for (auto prefix : query.minus_prefixes) {
+            const auto it = FindWordOrNext(document_words, prefix);
+            if (it != document_words.end() && it->first.substr(0, prefix.size()) == prefix) {
+                return { matched_words, attributes_.GetStatus(documents_.at(document_id).slot) };
+            }
+        }
+        for (auto prefix : query.plus_prefixes) {
+            for (auto it = FindWordOrNext(document_words, prefix);
+                it != document_words.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+                matched_words.push_back(it->first);
+            }
         }
     }
     for (auto word : query.plus_words) {
@@ -108,31 +222,668 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
             matched_words.push_back(word);
         }
     }
-    return { matched_words, documents_.at(document_id).status };
+    if (!query.plus_prefixes.empty()) {
+        sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    }
+    return { matched_words, attributes_.GetStatus(documents_.at(document_id).slot) };
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(
     const std::execution::parallel_policy&, string_view raw_query, int document_id) const {
     const auto query = ParseQueryPar(raw_query);
     vector<string_view> matched_words_o{};
-    if (any_of(query.minus_words.begin(), query.minus_words.end(), [this, &document_id](string_view word) {
-        return document_to_words_freqs_.at(document_id).count(word);
+    const auto& document_words = documents_.at(document_id).word_freqs;
+    if (any_of(query.minus_words.begin(), query.minus_words.end(), [&document_words](string_view word) {
+        return HasWord(document_words, word);
+        })) {
+        return { matched_words_o, attributes_.GetStatus(documents_.at(document_id).slot) };
+    }
+    if (any_of(query.minus_prefixes.begin(), query.minus_prefixes.end(), [&document_words](string_view prefix) {
+        const auto it = FindWordOrNext(document_words, prefix);
+        return it != document_words.end() && it->first.substr(0, prefix.size()) == prefix;
+        })) {
+        return { matched_words_o, attributes_.GetStatus(documents_.at(document_id).slot) };
+    }
+    if (!all_of(query.required_words.begin(), query.required_words.end(), [&document_words](string_view word) {
+        return HasWord(document_words, word);
         })) {
-        return { matched_words_o, documents_.at(document_id).status };
+        return { matched_words_o, attributes_.GetStatus(documents_.at(document_id).slot) };
     }
     vector<string_view> matched_words(query.plus_words.size());
     auto end = copy_if(execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
         [this, &document_id](string_view word) {
             return word_to_document_freqs_.count(word) & word_to_document_freqs_.at(word).count(document_id);
         });
+    matched_words.resize(end - matched_words.begin());
+    for (auto prefix : query.plus_prefixes) {
+        for (auto it = FindWordOrNext(document_words, prefix);
+            it != document_words.end() && it->first.substr(0, prefix.size()) == prefix; ++it) {
+            matched_words.push_back(it->first);
+        }
+    }
+    end = matched_words.end();
     sort(matched_words.begin(), end);
     end = unique(matched_words.begin(), end);
     matched_words.resize(end - matched_words.begin());
-    return { matched_words, documents_.at(document_id).status };
+    return { matched_words, attributes_.GetStatus(documents_.at(document_id).slot) };
+}
+
+vector<const SearchServer::InvertedIndex::value_type*> SearchServer::ExpandPrefix(string_view prefix) const {
+    vector<const InvertedIndex::value_type*> expansions;
+    if (corpus_statistics_ != nullptr) {
+        // The words are chosen from the whole corpus, so every server sharing the
+        // statistics expands the prefix to the same words and keeps those it has
+        const auto& document_freqs = corpus_statistics_->document_freqs;
+        size_t count = 0;
+        for (auto it = document_freqs.lower_bound(prefix);
+            it != document_freqs.end() && count < MAX_PREFIX_EXPANSIONS && string_view(it->first).substr(0, prefix.size()) == prefix;
+            ++it, ++count) {
+            const auto entry = word_to_document_freqs_.find(it->first);
+            if (entry != word_to_document_freqs_.end() && !entry->second.empty()) {
+                expansions.push_back(&*entry);
+            }
+        }
+        return expansions;
+    }
+    term_dictionary_.ForEachWithPrefix(prefix, MAX_PREFIX_EXPANSIONS,
+        [&expansions](string_view, const InvertedIndex::value_type* entry) {
+            expansions.push_back(entry);
+        });
+    return expansions;
+}
+
+namespace {
+
+// Steps to walk a minus-word posting list along with a plus-word one: either
+// a linear merge or a lower_bound from the root for every plus posting
+double EstimateMergeCost(size_t plus_posting_count, size_t minus_posting_count) {
+    return min(static_cast<double>(plus_posting_count + minus_posting_count),
+        plus_posting_count * log2(minus_posting_count + 1.0));
+}
+
+}  // namespace
+
+SearchServer::PostingCursor SearchServer::MakePostingCursor(const PostingList& postings, size_t probe_count) {
+    const bool seek = probe_count * log2(postings.size() + 1.0) < probe_count + postings.size();
+    return { postings.begin(), &postings, seek };
+}
+
+SearchServer::MinusFilter::Cursor SearchServer::MinusFilter::MakeCursor(size_t plus_posting_count) const {
+    Cursor cursor;
+    ResetCursor(cursor, plus_posting_count);
+    return cursor;
+}
+
+void SearchServer::MinusFilter::ResetCursor(Cursor& cursor, size_t plus_posting_count) const {
+    cursor.positions_.clear();
+    if (use_bitmap_) {
+        cursor.bitmap_ = &bitmap_;
+        return;
+    }
+    cursor.bitmap_ = nullptr;
+    for (const PostingList* postings : minus_postings_) {
+        cursor.positions_.push_back(MakePostingCursor(*postings, plus_posting_count));
+    }
+}
+
+void SearchServer::MinusFilter::Clear() {
+    if (use_bitmap_) {
+        bitmap_.Clear();
+    }
+    minus_postings_.clear();
+    use_bitmap_ = false;
+}
+
+SearchServer::MinusFilter SearchServer::BuildMinusFilter(const Query& query) const {
+    MinusFilter minus_filter;
+    BuildMinusFilter(query, minus_filter);
+    return minus_filter;
+}
+
+void SearchServer::BuildMinusFilter(const Query& query, MinusFilter& minus_filter) const {
+    minus_filter.Clear();
+    vector<const PostingList*>& minus_postings = minus_filter.minus_postings_;
+    for (string_view word : query.minus_words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it != word_to_document_freqs_.end() && !it->second.empty()) {
+            minus_postings.push_back(&it->second);
+        }
+    }
+    for (string_view prefix : query.minus_prefixes) {
+        for (const auto* entry : ExpandPrefix(prefix)) {
+            minus_postings.push_back(&entry->second);
+        }
+    }
+    if (minus_postings.empty()) {
+        return;
+    }
+
+    // The bitmap costs one pass over the minus postings and one bit test per plus posting
+    double bitmap_cost = attributes_.GetSlotCount() / 64.0;
+    double merge_cost = 0.0;
+    for (const PostingList* postings : minus_postings) {
+        bitmap_cost += postings->size();
+    }
+    const auto add_plus_postings = [&](size_t plus_posting_count) {
+        bitmap_cost += plus_posting_count;
+        for (const PostingList* postings : minus_postings) {
+            merge_cost += EstimateMergeCost(plus_posting_count, postings->size());
+        }
+    };
+
+    // A prefix may match any document, so its posting count is bounded by the corpus size.
+    // With required words only the shortest of their posting lists is traversed.
+    if (!query.required_words.empty()) {
+        size_t shortest_posting_count = 0;
+        bool has_postings = false;
+        for (string_view word : query.required_words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end()) {
+                shortest_posting_count = has_postings ? min(shortest_posting_count, it->second.size()) : it->second.size();
+                has_postings = true;
+            }
+        }
+        add_plus_postings(shortest_posting_count);
+    }
+    else {
+        for (string_view word : query.plus_words) {
+            const auto it = word_to_document_freqs_.find(word);
+            if (it != word_to_document_freqs_.end()) {
+                add_plus_postings(it->second.size());
+            }
+        }
+        for (size_t i = 0; i < query.plus_prefixes.size(); ++i) {
+            add_plus_postings(documents_.size());
+        }
+    }
+
+    minus_filter.use_bitmap_ = bitmap_cost < merge_cost;
+    if (minus_filter.use_bitmap_) {
+        for (const PostingList* postings : minus_postings) {
+            for (const auto& [document_id, posting] : *postings) {
+                minus_filter.bitmap_.Set(posting.slot);
+            }
+        }
+    }
+}
+
+vector<pair<int, int>> SearchServer::IntersectRequiredWords(const Query& query, const MinusFilter& minus_filter) const {
+    vector<const PostingList*> required_postings;
+    for (string_view word : query.required_words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end() || it->second.empty()) {
+            return {};
+        }
+        required_postings.push_back(&it->second);
+    }
+    sort(required_postings.begin(), required_postings.end(), [](const PostingList* lhs, const PostingList* rhs) {
+        return lhs->size() < rhs->size();
+        });
+
+    const PostingList& shortest = *required_postings.front();
+    vector<PostingCursor> cursors;
+    cursors.reserve(required_postings.size() - 1);
+    for (auto it = next(required_postings.begin()); it != required_postings.end(); ++it) {
+        cursors.push_back(MakePostingCursor(**it, shortest.size()));
+    }
+    auto minus_cursor = minus_filter.MakeCursor(shortest.size());
+
+    vector<pair<int, int>> documents;
+    for (const auto& [document_id, posting] : shortest) {
+        const bool has_all_words = all_of(cursors.begin(), cursors.end(), [document_id = document_id](PostingCursor& cursor) {
+            return cursor.AdvanceTo(document_id);
+            });
+        if (has_all_words && !minus_cursor.IsExcluded(document_id, posting.slot)) {
+            documents.emplace_back(document_id, posting.slot);
+        }
+    }
+    return documents;
+}
+
+SearchPage SearchServer::FindFirstPage(string_view raw_query, size_t page_size, DocumentStatus status, QueryMode mode) const {
+    LOG_TRACE("FindFirstPage"sv);
+    SearchCursor cursor;
+    cursor.raw_query_ = string(raw_query);
+    cursor.status_ = status;
+    cursor.mode_ = mode;
+    return FetchNextPage(cursor, page_size);
+}
+
+SearchPage SearchServer::FetchNextPage(const SearchCursor& cursor, size_t page_size) const {
+    TraceSpan span("FetchNextPage"sv);
+    span.AddArg("query"sv, cursor.raw_query_);
+    span.AddArg("page_size"sv, page_size);
+    SearchPage page{ {}, cursor };
+    if (cursor.is_end_ || page_size == 0) {
+        return page;
+    }
+
+    // One more document than the page tells whether another page follows
+    auto documents = FindPageCandidates(cursor, page_size < numeric_limits<size_t>::max() ? page_size + 1 : page_size);
+    page.next.is_end_ = documents.size() <= page_size;
+    if (documents.size() > page_size) {
+        partial_sort(documents.begin(), documents.begin() + page_size, documents.end(), IsMoreRelevant);
+        documents.resize(page_size);
+    }
+    else {
+        sort(documents.begin(), documents.end(), IsMoreRelevant);
+    }
+
+    if (!documents.empty()) {
+        page.next.has_last_ = true;
+        page.next.last_relevance_ = documents.back().relevance;
+        page.next.last_rating_ = documents.back().rating;
+        page.next.last_document_id_ = documents.back().id;
+    }
+    page.documents = move(documents);
+    span.AddArg("documents"sv, page.documents.size());
+    return page;
+}
+
+vector<Document> SearchServer::FindPageCandidates(const SearchCursor& cursor, size_t count) const {
+    const auto is_after_cursor = [&cursor](const Document& document) {
+        return !cursor.has_last_
+            || IsMoreRelevant(Document(cursor.last_document_id_, cursor.last_relevance_, cursor.last_rating_), document);
+    };
+    TraceSpan span("FindPageCandidates"sv);
+    const StatusFilter status_filter{ cursor.status_ };
+    const Query query = ParseQuery(cursor.raw_query_);
+    if (cursor.mode_ == QueryMode::ALL || !query.required_words.empty() || !query.plus_prefixes.empty()) {
+        span.AddArg("pruning"sv, "none"sv);
+        auto documents = FindAllDocuments(cursor.raw_query_, status_filter, cursor.mode_);
+        documents.erase(
+            remove_if(documents.begin(), documents.end(), [&is_after_cursor](const Document& document) {
+                return !is_after_cursor(document);
+                }),
+            documents.end());
+        span.AddArg("candidates"sv, documents.size());
+        return documents;
+    }
+
+    struct Term {
+        PostingCursor position;
+        double inverse_document_freq;
+        // No document gets more from the word
+        double max_relevance;
+    };
+    vector<Term> terms;
+    size_t posting_count = 0;
+    for (string_view word : query.plus_words) {
+        if (const PostingList* postings = FindPostingList(word)) {
+            const double inverse_document_freq = ComputeInverseDocumentFreq(word, postings->size());
+            // Zero bounds a negative IDF too
+            const double max_relevance = max(max_term_freqs_.at(word) * inverse_document_freq, 0.0);
+            terms.push_back({ { postings->begin(), postings, false }, inverse_document_freq, max_relevance });
+            posting_count += postings->size();
+        }
+    }
+    for (Term& term : terms) {
+        term.position = MakePostingCursor(*term.position.postings, posting_count - term.position.postings->size());
+    }
+
+    // Words by increasing bound. The first non_essential_count of them can't lift a document
+    // to the threshold together, so only documents of the others are visited.
+    vector<Term*> by_bound;
+    for (Term& term : terms) {
+        by_bound.push_back(&term);
+    }
+    sort(by_bound.begin(), by_bound.end(), [](const Term* lhs, const Term* rhs) {
+        return lhs->max_relevance < rhs->max_relevance;
+        });
+    vector<double> bound_sums(1, 0.0);
+    for (const Term* term : by_bound) {
+        bound_sums.push_back(bound_sums.back() + term->max_relevance);
+    }
+    size_t non_essential_count = 0;
+
+    const MinusFilter minus_filter = BuildMinusFilter(query);
+    auto minus_cursor = minus_filter.MakeCursor(posting_count);
+    // Relevances of the count best documents found so far, the lowest on top. A document
+    // more than EPSILON below the lowest one is ranked after all of them.
+    vector<double> best_relevances;
+    double threshold = -numeric_limits<double>::infinity();
+    vector<Document> documents;
+    size_t visited_count = 0;
+    size_t scored_count = 0;
+
+    while (non_essential_count < by_bound.size()) {
+        bool is_found = false;
+        int document_id = 0;
+        for (size_t index = non_essential_count; index < by_bound.size(); ++index) {
+            const PostingCursor& position = by_bound[index]->position;
+            if (position.current != position.postings->end() && (!is_found || position.current->first < document_id)) {
+                is_found = true;
+                document_id = position.current->first;
+            }
+        }
+        if (!is_found) {
+            break;
+        }
+
+        ++visited_count;
+        int slot = 0;
+        double bound = bound_sums[non_essential_count];
+        for (size_t index = non_essential_count; index < by_bound.size(); ++index) {
+            const Term& term = *by_bound[index];
+            if (term.position.current != term.position.postings->end() && term.position.current->first == document_id) {
+                slot = term.position.current->second.slot;
+                bound += term.position.current->second.term_freq * term.inverse_document_freq;
+            }
+        }
+        if (bound >= threshold - EPSILON && IsAccepted(status_filter, document_id, slot) && !minus_cursor.IsExcluded(document_id, slot)) {
+            // Summed in query order, like FindAllDocuments does
+            ++scored_count;
+            double relevance = 0.0;
+            for (Term& term : terms) {
+                if (term.position.AdvanceTo(document_id)) {
+                    relevance += term.position.current->second.term_freq * term.inverse_document_freq;
+                }
+            }
+            const Document document(document_id, relevance, attributes_.GetRating(slot));
+            if (relevance >= threshold - EPSILON && is_after_cursor(document)) {
+                documents.push_back(document);
+                best_relevances.push_back(relevance);
+                push_heap(best_relevances.begin(), best_relevances.end(), greater<double>());
+                if (best_relevances.size() > count) {
+                    pop_heap(best_relevances.begin(), best_relevances.end(), greater<double>());
+                    best_relevances.pop_back();
+                }
+                if (best_relevances.size() == count && best_relevances.front() > threshold) {
+                    threshold = best_relevances.front();
+                    while (non_essential_count < by_bound.size() && bound_sums[non_essential_count + 1] < threshold - EPSILON) {
+                        ++non_essential_count;
+                    }
+                }
+                if (documents.size() >= 2 * count + 64) {
+                    documents.erase(
+                        remove_if(documents.begin(), documents.end(), [threshold](const Document& candidate) {
+                            return candidate.relevance < threshold - EPSILON;
+                            }),
+                        documents.end());
+                }
+            }
+        }
+
+        for (size_t index = non_essential_count; index < by_bound.size(); ++index) {
+            PostingCursor& position = by_bound[index]->position;
+            if (position.current != position.postings->end() && position.current->first == document_id) {
+                ++position.current;
+            }
+        }
+    }
+    documents.erase(
+        remove_if(documents.begin(), documents.end(), [threshold](const Document& candidate) {
+            return candidate.relevance < threshold - EPSILON;
+            }),
+        documents.end());
+    span.AddArg("pruning"sv, "max_score"sv);
+    span.AddArg("postings"sv, posting_count);
+    span.AddArg("visited"sv, visited_count);
+    span.AddArg("scored"sv, scored_count);
+    span.AddArg("non_essential"sv, non_essential_count);
+    span.AddArg("candidates"sv, documents.size());
+    return documents;
+}
+
+SearchServer::QueryContext& SearchServer::GetThreadQueryContext() {
+    thread_local QueryContext context;
+    return context;
+}
+
+void SearchServer::SelectTopDocuments(QueryContext& context) {
+    vector<Document>& matched_documents = context.documents_;
+    sort(execution::seq, matched_documents.begin(), matched_documents.end(), IsMoreRelevant);
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+}
+
+void SearchServer::CollectMatchedDocuments(QueryContext& context) const {
+    vector<int>& slots = context.matched_slots_;
+    sort(slots.begin(), slots.end(), [this](int lhs, int rhs) {
+        return attributes_.GetDocumentId(lhs) < attributes_.GetDocumentId(rhs);
+        });
+    context.documents_.clear();
+    for (int slot : slots) {
+        context.documents_.push_back({ attributes_.GetDocumentId(slot), context.relevances_[slot], attributes_.GetRating(slot) });
+    }
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(const vector<string>& raw_queries) const {
+    TraceSpan span("FindTopDocumentsBatch"sv);
+    span.AddArg("queries"sv, raw_queries.size());
+    vector<vector<Document>> results(raw_queries.size());
+    vector<Query> queries;
+    vector<size_t> query_indexes;
+    vector<size_t> single_query_indexes;
+    queries.reserve(raw_queries.size());
+    for (size_t i = 0; i < raw_queries.size(); ++i) {
+        Query query = ParseQuery(raw_queries[i]);
+        if (query.plus_prefixes.empty() && query.required_words.empty()) {
+            queries.push_back(move(query));
+            query_indexes.push_back(i);
+        }
+        else {
+            single_query_indexes.push_back(i);
+        }
+    }
+    span.AddArg("single"sv, single_query_indexes.size());
+    for_each(execution::par, single_query_indexes.begin(), single_query_indexes.end(), [&](size_t i) {
+        results[i] = FindTopDocuments(raw_queries[i]);
+        });
+
+    // The scores of a group are stored slot by slot, so the queries sharing a posting
+    // update neighbouring values and the whole group stays within BATCH_ACCUMULATOR_SIZE.
+    // Except on small servers that is more than L2 holds; groups sized for the cache
+    // share fewer traversals and came out slower, see BATCH_ACCUMULATOR_SIZE.
+    const size_t group_size = clamp<size_t>(BATCH_ACCUMULATOR_SIZE / max<size_t>(attributes_.GetSlotCount(), 1), 1, 64);
+    vector<size_t> group_begins;
+    for (size_t begin = 0; begin < queries.size(); begin += group_size) {
+        group_begins.push_back(begin);
+    }
+    span.AddArg("groups"sv, group_begins.size());
+    for_each(execution::par, group_begins.begin(), group_begins.end(), [&](size_t begin) {
+        const size_t end = min(begin + group_size, queries.size());
+        vector<const Query*> group;
+        for (size_t i = begin; i < end; ++i) {
+            group.push_back(&queries[i]);
+        }
+        auto group_results = FindTopDocumentsShared(group);
+        for (size_t i = begin; i < end; ++i) {
+            results[query_indexes[i]] = move(group_results[i - begin]);
+        }
+        });
+    return results;
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsShared(const vector<const Query*>& queries) const {
+    const size_t query_count = queries.size();
+    // Words in sorted order, as in plus_words, so every query adds its words up in its own order
+    map<string_view, vector<size_t>> word_to_queries;
+    vector<MinusFilter> minus_filters;
+    minus_filters.reserve(query_count);
+    for (size_t query = 0; query < query_count; ++query) {
+        minus_filters.push_back(BuildMinusFilter(*queries[query]));
+        for (string_view word : queries[query]->plus_words) {
+            word_to_queries[word].push_back(query);
+        }
+    }
+
+    const size_t slot_count = attributes_.GetSlotCount();
+    vector<double> relevances(slot_count * query_count, 0.0);
+    // Bit i is set if query i has matched the slot
+    vector<uint64_t> slot_queries(slot_count, 0);
+    vector<int> matched_slots;
+    vector<MinusFilter::Cursor> minus_cursors(query_count);
+    for (const auto& [word, word_queries] : word_to_queries) {
+        const PostingList* word_postings = FindPostingList(word);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        const PostingList& postings = *word_postings;
+        const double inverse_document_freq = ComputeInverseDocumentFreq(word, postings.size());
+        for (size_t query : word_queries) {
+            if (!minus_filters[query].IsEmpty()) {
+                minus_cursors[query] = minus_filters[query].MakeCursor(postings.size());
+            }
+        }
+        for (const auto& [document_id, posting] : postings) {
+            if (!attributes_.HasStatus(posting.slot, DocumentStatus::ACTUAL)) {
+                continue;
+            }
+            const double relevance = posting.term_freq * inverse_document_freq;
+            double* const slot_relevances = &relevances[posting.slot * query_count];
+            const uint64_t previous_queries = slot_queries[posting.slot];
+            uint64_t queries_mask = previous_queries;
+            for (size_t query : word_queries) {
+                if (minus_filters[query].IsEmpty() || !minus_cursors[query].IsExcluded(document_id, posting.slot)) {
+                    slot_relevances[query] += relevance;
+                    queries_mask |= uint64_t{ 1 } << query;
+                }
+            }
+            if (previous_queries == 0 && queries_mask != 0) {
+                matched_slots.push_back(posting.slot);
+            }
+            slot_queries[posting.slot] = queries_mask;
+        }
+    }
+
+    // Documents come to each query in id order, as from FindAllDocuments
+    sort(matched_slots.begin(), matched_slots.end(), [this](int lhs, int rhs) {
+        return attributes_.GetDocumentId(lhs) < attributes_.GetDocumentId(rhs);
+        });
+    vector<vector<Document>> results(query_count);
+    for (int slot : matched_slots) {
+        for (size_t query = 0; query < query_count; ++query) {
+            if ((slot_queries[slot] >> query) & 1) {
+                results[query].push_back({ attributes_.GetDocumentId(slot), relevances[slot * query_count + query], attributes_.GetRating(slot) });
+            }
+        }
+    }
+    for (vector<Document>& documents : results) {
+        sort(execution::seq, documents.begin(), documents.end(), IsMoreRelevant);
+        if (documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+            documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+    }
+    return results;
+}
+
+void SearchServer::SetCorpusStatistics(const CorpusStatistics* corpus_statistics) {
+    corpus_statistics_ = corpus_statistics;
+}
+
+void SearchServer::SetDocumentStore(shared_ptr<DocumentStore> document_store) {
+    if (!documents_.empty()) {
+        throw invalid_argument("Document store can't be changed after documents are added"s);
+    }
+    document_store_ = move(document_store);
+}
+
+string SearchServer::GetDocumentText(int document_id) const {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        return {};
+    }
+    const DocumentData& document_data = it->second;
+    if (document_data.stored_text) {
+        return document_store_->Get(*document_data.stored_text);
+    }
+    return document_data.data;
+}
+
+const SearchServer::PostingList* SearchServer::FindPostingList(string_view word) const {
+    const auto it = word_to_document_freqs_.find(word);
+    if (it == word_to_document_freqs_.end() || it->second.empty()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+size_t SearchServer::GetIndexVersion() const {
+    return index_version_ + (corpus_statistics_ != nullptr ? corpus_statistics_->version : 0);
+}
+
+double SearchServer::ComputeCorpusInverseDocumentFreq(string_view word) const {
+    const auto it = corpus_statistics_->document_freqs.find(word);
+    if (it == corpus_statistics_->document_freqs.end()) {
+        throw out_of_range("Word is missing from corpus statistics"s);
+    }
+    return log(corpus_statistics_->document_count * 1.0 / it->second);
+}
+
+string_view SearchServer::InternWord(string_view word) {
+    auto it = words_.find(word);
+    if (it == words_.end()) {
+        it = words_.emplace(word).first;
+    }
+    return *it;
+}
+
+void SearchServer::EraseWord(InvertedIndex::iterator postings) {
+    const auto word = words_.find(postings->first);
+    term_dictionary_.Erase(postings->first);
+    max_term_freqs_.erase(postings->first);
+    word_to_document_freqs_.erase(postings);
+    words_.erase(word);
+}
+
+SearchServer::WordFrequencies::const_iterator SearchServer::FindWordOrNext(const WordFrequencies& word_freqs, string_view word) {
+    return lower_bound(word_freqs.begin(), word_freqs.end(), word,
+        [](const auto& entry, string_view value) {
+            return entry.first < value;
+        });
+}
+
+bool SearchServer::HasWord(const WordFrequencies& word_freqs, string_view word) {
+    const auto it = FindWordOrNext(word_freqs, word);
+    return it != word_freqs.end() && it->first == word;
+}
+
+namespace {
+
+// libstdc++ red-black tree node header: color and three links
+const size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+
+size_t GetHeapSize(const string& text) {
+    const char* data = text.data();
+    const char* object = reinterpret_cast<const char*>(&text);
+    const bool is_inline = data >= object && data < object + sizeof(text);
+    return is_inline ? 0 : text.capacity() + 1;
+}
+
+}  // namespace
+
+MemoryUsage SearchServer::GetMemoryUsage() const {
+    MemoryUsage usage;
+
+    usage.term_dictionary = term_dictionary_.GetMemoryUsage();
+    for (const string& word : words_) {
+        usage.term_dictionary += MAP_NODE_OVERHEAD + sizeof(word) + GetHeapSize(word);
+    }
+
+    for (const auto& [word, postings] : word_to_document_freqs_) {
+        usage.postings += MAP_NODE_OVERHEAD + sizeof(InvertedIndex::value_type)
+            + postings.size() * (MAP_NODE_OVERHEAD + sizeof(pair<const int, Posting>));
+    }
+    usage.postings += max_term_freqs_.size() * (MAP_NODE_OVERHEAD + sizeof(pair<const string_view, double>));
+
+    for (const auto& [document_id, document_data] : documents_) {
+        usage.forward_index += document_data.word_freqs.capacity() * sizeof(WordFrequencies::value_type);
+        usage.document_store += GetHeapSize(document_data.data);
+        usage.metadata += MAP_NODE_OVERHEAD + sizeof(pair<const int, DocumentData>);
+    }
+    usage.metadata += document_ids_.size() * (MAP_NODE_OVERHEAD + sizeof(int));
+    usage.metadata += attributes_.GetMemoryUsage();
+    if (document_store_) {
+        usage.document_store += document_store_->GetMemoryUsage();
+    }
+    return usage;
 }
 
 bool SearchServer::IsStopWord(string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
 bool SearchServer::IsValidWord(string_view word) {
@@ -142,6 +893,22 @@ bool SearchServer::IsValidWord(string_view word) {
         });
 }
 
+SearchServer::WordFrequencies SearchServer::ComputeWordFrequencies(string_view document) const {
+    auto words = SplitIntoWordsNoStop(document);
+    const double inv_word_count = 1.0 / words.size();
+    sort(words.begin(), words.end());
+
+    WordFrequencies word_freqs;
+    for (auto word : words) {
+        if (word_freqs.empty() || word_freqs.back().first != word) {
+            word_freqs.emplace_back(word, 0.0);
+        }
+        word_freqs.back().second += inv_word_count;
+    }
+    word_freqs.shrink_to_fit();
+    return word_freqs;
+}
+
 vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
     vector<string_view> words;
     for (string_view word : SplitIntoWords(text)) {
@@ -171,53 +938,81 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
     }
     string_view word = text;
     bool is_minus = false;
+    bool is_required = false;
     if (word[0] == '-') {
         is_minus = true;
         word = word.substr(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    else if (word[0] == '+') {
+        is_required = true;
+        word = word.substr(1);
+    }
+    bool is_prefix = false;
+    if (!word.empty() && word.back() == '*') {
+        is_prefix = true;
+        word.remove_suffix(1);
+    }
+    if (word.empty() || word[0] == '-' || word[0] == '+' || word.find('*') != word.npos || !IsValidWord(word)) {
         throw invalid_argument("Query word is invalid"s);
     }
+    if (is_required && is_prefix) {
+        throw invalid_argument("Prefix can't be required"s);
+    }
+
+    // A prefix may expand to ordinary words even if it is a stop word itself
+    return { word, is_minus, !is_prefix && IsStopWord(word), is_prefix, is_required };
+}
 
-    return { word, is_minus, IsStopWord(word) };
+void SearchServer::AddQueryWord(Query& query, const QueryWord& query_word) {
+    if (query_word.is_stop) {
+        return;
+    }
+    if (query_word.is_prefix) {
+        (query_word.is_minus ? query.minus_prefixes : query.plus_prefixes).push_back(query_word.data);
+    }
+    else {
+        (query_word.is_minus ? query.minus_words : query.plus_words).push_back(query_word.data);
+    }
+    if (query_word.is_required) {
+        query.required_words.push_back(query_word.data);
+    }
 }
 
 SearchServer::Query SearchServer::ParseQueryPar(string_view text) const {
     Query result;
     for (auto word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            }
-            else {
-                result.plus_words.push_back(query_word.data);
-            }
-        }
+        AddQueryWord(result, ParseQueryWord(word));
     }
     return result;
 }
 
 SearchServer::Query SearchServer::ParseQuery(string_view text) const {
     Query result;
-    for (auto word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            }
-            else {
-                result.plus_words.push_back(query_word.data);
-            }
-        }
+    vector<string_view> words;
+    ParseQuery(text, words, result);
+    return result;
+}
+
+void SearchServer::ParseQuery(string_view text, vector<string_view>& words, Query& result) const {
+    for (auto* query_words : { &result.plus_words, &result.minus_words, &result.plus_prefixes, &result.minus_prefixes, &result.required_words }) {
+        query_words->clear();
     }
+    SplitIntoWords(text, words);
+    for (auto word : words) {
+        AddQueryWord(result, ParseQueryWord(word));
+    }
+    for (auto* prefixes : { &result.minus_prefixes, &result.plus_prefixes }) {
+        sort(prefixes->begin(), prefixes->end());
+        prefixes->erase(unique(prefixes->begin(), prefixes->end()), prefixes->end());
+    }
+    sort(result.required_words.begin(), result.required_words.end());
+    result.required_words.erase(unique(result.required_words.begin(), result.required_words.end()), result.required_words.end());
     sort(result.minus_words.begin(), result.minus_words.end());
     auto end_minus = unique(result.minus_words.begin(), result.minus_words.end());
     result.minus_words.resize(end_minus - result.minus_words.begin());
     sort(result.plus_words.begin(), result.plus_words.end());
     auto end_plus = unique(result.plus_words.begin(), result.plus_words.end());
     result.plus_words.resize(end_plus - result.plus_words.begin());
-    return result;
 }
 
 
@@ -10,49 +10,222 @@
 #include <iterator>
 #include <execution>
 #include <string_view>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <limits>
 
 
 #include "document.h"
 #include "string_processing.h"
 #include "log_duration.h"
 #include "concurrent_map.h"
+#include "trace.h"
+#include "term_dictionary.h"
+#include "document_attributes.h"
+#include "stop_word_set.h"
+#include "document_store.h"
+
+using namespace std::string_view_literals;
 
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
+const size_t MAX_PREFIX_EXPANSIONS = 64;
+// Accumulated scores of one query group of FindTopDocumentsBatch, 8 MB of doubles.
+// This is not sized to stay in cache: groups small enough for L2 were slower than
+// these larger ones, because fewer queries shared each posting traversal.
+const size_t BATCH_ACCUMULATOR_SIZE = 1 << 20;
+// Postings scored between two checks of a QueryBudget
+const size_t POSTING_BLOCK_SIZE = 256;
 inline static constexpr double EPSILON = 1e-6;
 
+// Ranking order of FindTopDocuments: by relevance, ties broken by rating and then by id
+inline bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+// Approximate heap usage of a SearchServer by structure, in bytes
+struct MemoryUsage {
+    size_t term_dictionary = 0;
+    size_t postings = 0;
+    size_t forward_index = 0;
+    size_t document_store = 0;
+    size_t metadata = 0;
+
+    size_t GetTotal() const {
+        return term_dictionary + postings + forward_index + document_store + metadata;
+    }
+};
+
+// How the plus words of a query combine: ANY finds documents with at least one
+// of them, ALL only documents with every one, as if each were written as +word.
+// Prefix words are scored in both modes but never required.
+enum class QueryMode {
+    ANY,
+    ALL,
+};
+
+// Limits of the work of one query. The budget is checked after every
+// POSTING_BLOCK_SIZE postings, within the merge of a prefix too, so a query may
+// score a block and a document more than max_postings. Words are then scored from the rarest, so the
+// documents found before the budget runs out are the best candidates.
+// Queries with required words are bounded by their rarest word and are not cut.
+struct QueryBudget {
+    // Postings scored at most, 0 for no limit
+    size_t max_postings = 0;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    bool IsLimited() const {
+        return max_postings != 0 || deadline != std::chrono::steady_clock::time_point::max();
+    }
+
+    bool IsExhausted(size_t scored_postings) const {
+        return (max_postings != 0 && scored_postings >= max_postings)
+            || (deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline);
+    }
+};
+
+struct SearchResult {
+    std::vector<Document> documents;
+    // The budget ran out before all the postings were scored
+    bool is_approximate = false;
+};
+
+// Position in the ranking of a query after the last document of a page.
+// It keeps the query, so the next page can be fetched without it.
+class SearchCursor {
+public:
+    // No documents are left after the cursor
+    bool IsEnd() const {
+        return is_end_;
+    }
+
+private:
+    friend class SearchServer;
+
+    std::string raw_query_;
+    DocumentStatus status_ = DocumentStatus::ACTUAL;
+    QueryMode mode_ = QueryMode::ANY;
+    bool has_last_ = false;
+    double last_relevance_ = 0.0;
+    int last_rating_ = 0;
+    int last_document_id_ = 0;
+    bool is_end_ = false;
+};
+
+struct SearchPage {
+    std::vector<Document> documents;
+    SearchCursor next;
+};
+
+// Document frequencies of a corpus that is split between several servers.
+// A server attached to it computes IDF from the whole corpus instead of its own part.
+struct CorpusStatistics {
+    int document_count = 0;
+    std::map<std::string, int, std::less<>> document_freqs;
+    // Changed by every document added to the corpus or removed from it
+    size_t version = 0;
+};
+
 class SearchServer {
 public:
+    // Words of a document with their term frequencies, sorted by word
+    using WordFrequencies = std::vector<std::pair<std::string_view, double>>;
+
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
 
     explicit SearchServer(const std::string& stop_words_text);
 
+    // Stop words hashed at compile time by MakeStopWordTable
+    template <size_t N>
+    explicit SearchServer(const StopWordTable<N>& stop_words);
+
+    SearchServer(const SearchServer& other);
+
+    SearchServer(SearchServer&&) = default;
+
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    // Splits a document into words and counts them without touching the index, so it
+    // may run on another thread while documents are added. The words are views into document.
+    WordFrequencies ComputeWordFrequencies(std::string_view document) const;
+
+    // Adds a document whose words were counted by ComputeWordFrequencies(document)
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings, WordFrequencies word_freqs);
+
+    // Change the attributes of a document without reindexing its text. They may be
+    // called while queries run; a query sees either the old or the new value.
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    void SetDocumentRating(int document_id, const std::vector<int>& ratings);
+
+    // Sequential FindTopDocuments scores into the QueryContext of the calling thread, which
+    // the thread keeps until it exits; so do the TBB workers running ProcessQueries. A context
+    // holds about 8 bytes per document slot of the largest server it has served (relevances
+    // and two bitmaps) and the lists of its largest query. Passing a QueryContext explicitly
+    // keeps that memory under the caller's control.
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode = QueryMode::ANY) const;
 
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode = QueryMode::ANY) const;
 
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, QueryMode mode = QueryMode::ANY) const;
 
     template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, QueryMode mode = QueryMode::ANY) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, QueryMode mode) const;
 
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
 
+    // Buffers of a query kept for the next one: once they have grown, a query of plus
+    // and minus words allocates nothing. A context serves one query at a time and may
+    // be used with any server. Sequential FindTopDocuments uses one per thread.
+    class QueryContext;
+
+    // FindTopDocuments with the buffers of context; the result stays in it until its next query
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode = QueryMode::ANY) const;
+
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, std::string_view raw_query,
+        DocumentStatus status = DocumentStatus::ACTUAL, QueryMode mode = QueryMode::ANY) const;
+
+    // FindTopDocuments within the budget, the best documents scored so far if it runs out
+    template <typename DocumentPredicate>
+    SearchResult FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentPredicate document_predicate, QueryMode mode = QueryMode::ANY) const;
+
+    SearchResult FindTopDocuments(std::string_view raw_query, const QueryBudget& budget,
+        DocumentStatus status = DocumentStatus::ACTUAL, QueryMode mode = QueryMode::ANY) const;
+
+    // FindTopDocuments(raw_query) of every query. Queries of plus and minus words are
+    // evaluated in groups: each posting list is traversed once for all the queries of
+    // a group containing its word, and every query adds its words up in the same order
+    // as on its own, so the results are the same. Queries with prefixes or required
+    // words are evaluated on their own, in parallel with each other. A group keeps a score
+    // for every slot and query in it, up to BATCH_ACCUMULATOR_SIZE, so its scores don't fit
+    // in cache unless the server is small.
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries) const;
+
     int GetDocumentCount() const;
 
     std::set<int>::iterator begin();
 
     std::set<int>::iterator end();
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    const WordFrequencies& GetWordFrequencies(int document_id) const;
+
+    MemoryUsage GetMemoryUsage() const;
 
     void RemoveDocument(int document_id);
 
@@ -71,18 +244,124 @@ public:
         MatchDocument(const std::execution::parallel_policy&,
             std::string_view raw_query, int document_id) const;
 
+    // The statistics must outlive the server; nullptr detaches it.
+    void SetCorpusStatistics(const CorpusStatistics* corpus_statistics);
+
+    // Texts of the documents go to the store instead of memory. It can only be set
+    // while the server is empty; nullptr keeps the texts in memory. Copies of the
+    // server share the store.
+    void SetDocumentStore(std::shared_ptr<DocumentStore> document_store);
+
+    // Empty if there is no such document
+    std::string GetDocumentText(int document_id) const;
+
+    // Pages of the whole ranking of FindTopDocuments, not only its first
+    // MAX_RESULT_DOCUMENT_COUNT documents. Queries of plus and minus words are
+    // evaluated document at a time with max-score pruning: once page_size documents
+    // after the cursor are found, the words whose bounds together can't reach them
+    // are only probed for the documents of the other words. Queries with prefixes or
+    // required words, QueryMode::ALL included, score every match.
+    SearchPage FindFirstPage(std::string_view raw_query, size_t page_size,
+        DocumentStatus status = DocumentStatus::ACTUAL, QueryMode mode = QueryMode::ANY) const;
+
+    SearchPage FetchNextPage(const SearchCursor& cursor, size_t page_size) const;
+
 private:
+    friend class ImpactIndex;
+
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
+        // Position of the rating and status in attributes_
+        int slot;
+        // Empty if the text is in document_store_
         std::string data;
+        std::optional<DocumentStore::Location> stored_text;
+        WordFrequencies word_freqs;
+    };
+    struct Posting {
+        double term_freq;
+        int slot;
     };
-    const std::set<std::string_view, std::less<>> stop_words_;
+    using PostingList = std::map<int, Posting>;
+    using InvertedIndex = std::map<std::string_view, PostingList>;
+
+    // Position in a posting list that only moves forward
+    struct PostingCursor {
+        PostingList::const_iterator current;
+        const PostingList* postings;
+        // Jump with lower_bound instead of stepping when the list is much longer than the number of probes
+        bool seek;
+
+        // Moves to the first posting not before document_id and tells whether it is document_id
+        bool AdvanceTo(int document_id);
+    };
+
+    static PostingCursor MakePostingCursor(const PostingList& postings, size_t probe_count);
+
+    // Documents containing a minus word of a query, collected before the plus words
+    // are scored so that excluded documents are skipped instead of scored and erased.
+    // Depending on the posting lengths it is either a bitmap of slots, or the minus-word
+    // postings walked along with each plus-word posting list in document id order.
+    class MinusFilter {
+    public:
+        class Cursor {
+        public:
+            // Calls must come in ascending document id order
+            bool IsExcluded(int document_id, int slot);
 
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_words_freqs_;
+        private:
+            friend class MinusFilter;
+
+            const SlotBitmap* bitmap_ = nullptr;
+            std::vector<PostingCursor> positions_;
+        };
+
+        // Cursor for a plus-word posting list of the given length
+        Cursor MakeCursor(size_t plus_posting_count) const;
+
+        // MakeCursor reusing the memory of cursor
+        void ResetCursor(Cursor& cursor, size_t plus_posting_count) const;
+
+        // Leaves no minus words, keeping the memory for the next query
+        void Clear();
+
+        bool IsEmpty() const {
+            return minus_postings_.empty();
+        }
+
+        bool UsesBitmap() const {
+            return use_bitmap_;
+        }
+
+    private:
+        friend class SearchServer;
+
+        std::vector<const PostingList*> minus_postings_;
+        SlotBitmap bitmap_;
+        bool use_bitmap_ = false;
+    };
+
+    const StopWordSet stop_words_;
+
+    // Every indexed word is stored once here, the indexes keep views into it.
+    // A word goes away with its last posting; a copy of the server has its own words.
+    std::set<std::string, std::less<>> words_;
+    InvertedIndex word_to_document_freqs_;
+    // Words with a non-empty posting list
+    TermDictionary<const InvertedIndex::value_type*> term_dictionary_;
+    // Largest term frequency in the posting list of each word, the score bound of
+    // FetchNextPage. Removals do not lower it, so it stays an upper bound.
+    std::map<std::string_view, double> max_term_freqs_;
     std::map<int, DocumentData> documents_;
     std::set<int> document_ids_;
+    DocumentAttributes attributes_;
+    const CorpusStatistics* corpus_statistics_ = nullptr;
+    std::shared_ptr<DocumentStore> document_store_;
+    // Changed by every AddDocument and RemoveDocument that changes the index
+    size_t index_version_ = 0;
+
+    // Changes whenever the postings or the IDF of a word may have changed,
+    // those of the CorpusStatistics included
+    size_t GetIndexVersion() const;
 
     bool IsStopWord(std::string_view word) const;
 
@@ -92,10 +371,21 @@ private:
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    std::string_view InternWord(std::string_view word);
+
+    // Drops a word whose posting list has become empty from the index, the dictionary and words_
+    void EraseWord(InvertedIndex::iterator postings);
+
+    static WordFrequencies::const_iterator FindWordOrNext(const WordFrequencies& word_freqs, std::string_view word);
+
+    static bool HasWord(const WordFrequencies& word_freqs, std::string_view word);
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        bool is_prefix;
+        bool is_required;
     };
 
     QueryWord ParseQueryWord(std::string_view text) const;
@@ -103,55 +393,171 @@ private:
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<std::string_view> plus_prefixes;
+        std::vector<std::string_view> minus_prefixes;
+        // Plus words every found document must contain, also listed in plus_words
+        std::vector<std::string_view> required_words;
     };
 
+    static void AddQueryWord(Query& query, const QueryWord& query_word);
+
     Query ParseQuery(std::string_view text) const;
 
+    // Fills query reusing its memory, and that of words for the split text
+    void ParseQuery(std::string_view text, std::vector<std::string_view>& words, Query& query) const;
+
     Query ParseQueryPar(std::string_view text) const;
 
+    // nullptr if no document contains the word. A posting list is only looked up
+    // through it, so a word without documents never reaches the IDF computation,
+    // which throws for a word missing from CorpusStatistics.
+    const PostingList* FindPostingList(std::string_view word) const;
+
     double ComputeWordInverseDocumentFreq(std::string_view word) const {
-        return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+        return ComputeInverseDocumentFreq(word, word_to_document_freqs_.at(word).size());
+    }
+
+    double ComputeInverseDocumentFreq(std::string_view word, size_t document_freq) const {
+        if (corpus_statistics_ != nullptr) {
+            return ComputeCorpusInverseDocumentFreq(word);
+        }
+        return log(GetDocumentCount() * 1.0 / document_freq);
     }
 
+    double ComputeCorpusInverseDocumentFreq(std::string_view word) const;
+
+    // Chooses between the bitmap and the merge by the estimated cost of the traversal
+    MinusFilter BuildMinusFilter(const Query& query) const;
+
+    void BuildMinusFilter(const Query& query, MinusFilter& minus_filter) const;
+
+    // Documents containing all required words and no minus word, as (id, slot) in id order.
+    // The shortest posting list drives the intersection, the others are probed in step.
+    std::vector<std::pair<int, int>> IntersectRequiredWords(const Query& query, const MinusFilter& minus_filter) const;
+
+    // Scores the documents found by IntersectRequiredWords from the forward index,
+    // adding the words up in the same order as the posting traversal does
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindAllRequiredDocuments(ExecutionPolicy&& policy, const Query& query,
+        const MinusFilter& minus_filter, const DocumentPredicate& document_predicate) const;
+
+    // Documents ranked after the cursor that may be among its next count ones;
+    // FetchNextPage selects the page from them
+    std::vector<Document> FindPageCandidates(const SearchCursor& cursor, size_t count) const;
+
+    // Non-empty index entries for at most MAX_PREFIX_EXPANSIONS words starting with prefix.
+    // With CorpusStatistics these are the first words of the whole corpus, not of this server.
+    std::vector<const InvertedIndex::value_type*> ExpandPrefix(std::string_view prefix) const;
+
+    // Scores all expansions of prefix in a single merge over their postings,
+    // calling accumulate(document_id, slot, relevance) once per document.
+    template <typename Accumulate>
+    void ForEachPrefixMatch(std::string_view prefix, Accumulate accumulate) const {
+        ForEachPrefixMatch(prefix, accumulate, [](size_t) { return false; });
+    }
+
+    // The merge stops early if is_exhausted(merged postings), asked between documents
+    // after every POSTING_BLOCK_SIZE postings, returns true. Returns the postings merged.
+    template <typename Accumulate, typename IsExhausted>
+    size_t ForEachPrefixMatch(std::string_view prefix, Accumulate accumulate, IsExhausted is_exhausted) const;
+
+    // StatusFilter and RatingRange are checked against the attribute columns directly,
+    // other predicates get the values of the document.
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    bool IsAccepted(const DocumentPredicate& document_predicate, int document_id, int slot) const;
+
+    // Shared traversal of FindTopDocumentsBatch for at most 64 queries of plus and minus words
+    std::vector<std::vector<Document>> FindTopDocumentsShared(const std::vector<const Query*>& queries) const;
 
+    static QueryContext& GetThreadQueryContext();
+
+    // Puts the documents matched by the query into context.documents_ in id order
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    void FindAllDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode,
+        const QueryBudget& budget = {}) const;
+
+    // Sorts context.documents_ and leaves the first MAX_RESULT_DOCUMENT_COUNT
+    static void SelectTopDocuments(QueryContext& context);
+
+    // Moves the accumulated documents of context into context.documents_
+    void CollectMatchedDocuments(QueryContext& context) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const;
+};
+
+class SearchServer::QueryContext {
+private:
+    friend class SearchServer;
+
+    // Zeroes the relevances left by the previous query and fits them to slot_count slots
+    void ResetRelevances(int slot_count) {
+        for (int slot : matched_slots_) {
+            relevances_[slot] = 0.0;
+            matched_.Reset(slot);
+        }
+        matched_slots_.clear();
+        if (relevances_.size() < static_cast<size_t>(slot_count)) {
+            relevances_.resize(slot_count, 0.0);
+        }
+    }
+
+    void AddRelevance(int slot, double relevance) {
+        if (!matched_.Test(slot)) {
+            matched_.Set(slot);
+            matched_slots_.push_back(slot);
+        }
+        relevances_[slot] += relevance;
+    }
+
+    std::vector<std::string_view> words_;
+    Query query_;
+    MinusFilter minus_filter_;
+    MinusFilter::Cursor minus_cursor_;
+    // Relevance by slot, zero for the slots not in matched_slots_
+    std::vector<double> relevances_;
+    SlotBitmap matched_;
+    std::vector<int> matched_slots_;
+    std::vector<Document> documents_;
+    bool is_approximate_ = false;
 };
 
     template <typename StringContainer>
     SearchServer::SearchServer(const StringContainer& stop_words)
         : stop_words_(MakeUniqueNonEmptyStrings(stop_words)) 
     {
-        if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
+        if (!all_of(stop_words_.GetWords().begin(), stop_words_.GetWords().end(), IsValidWord)) {
             throw std::invalid_argument("Some of stop words are invalid");
         }
     }
+
+    template <size_t N>
+    SearchServer::SearchServer(const StopWordTable<N>& stop_words)
+        : stop_words_(stop_words) {
+    }
   
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-        return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+        return SearchServer::FindTopDocuments(std::execution::seq, raw_query, document_predicate, mode);
     }
 
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-        auto matched_documents = SearchServer::FindAllDocuments(policy, raw_query, document_predicate);
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            return FindTopDocuments(GetThreadQueryContext(), raw_query, document_predicate, mode);
+        }
+        auto matched_documents = SearchServer::FindAllDocuments(policy, raw_query, document_predicate, mode);
 
         std::sort(
             policy,
             matched_documents.begin(), matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                if (std::abs(lhs.relevance - rhs.relevance) < EPSILON) {
-                    return lhs.rating > rhs.rating;
-                }
-                else {
-                    return lhs.relevance > rhs.relevance;
-                }
-            });
+            IsMoreRelevant);
 
         if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
             matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
@@ -159,11 +565,24 @@ private:
         return matched_documents;
     }
 
+    template <typename DocumentPredicate>
+    const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+        FindAllDocuments(context, raw_query, document_predicate, mode);
+        SelectTopDocuments(context);
+        return context.documents_;
+    }
+
+    template <typename DocumentPredicate>
+    SearchResult SearchServer::FindTopDocuments(std::string_view raw_query, const QueryBudget& budget, DocumentPredicate document_predicate, QueryMode mode) const {
+        QueryContext& context = GetThreadQueryContext();
+        FindAllDocuments(context, raw_query, document_predicate, mode, budget);
+        SelectTopDocuments(context);
+        return { context.documents_, context.is_approximate_ };
+    }
+
     template <typename ExecutionPolicy>
-    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
-        return FindTopDocuments(policy, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-            });
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, QueryMode mode) const {
+        return FindTopDocuments(policy, raw_query, StatusFilter{ status }, mode);
     }
 
     template <typename ExecutionPolicy>
@@ -172,83 +591,313 @@ private:
     }
 
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    bool SearchServer::IsAccepted(const DocumentPredicate& document_predicate, int document_id, int slot) const {
+        if constexpr (std::is_same_v<DocumentPredicate, StatusFilter>) {
+            return attributes_.HasStatus(slot, document_predicate.status);
+        }
+        else if constexpr (std::is_same_v<DocumentPredicate, RatingRange>) {
+            const int rating = attributes_.GetRating(slot);
+            return document_predicate.min_rating <= rating && rating <= document_predicate.max_rating;
+        }
+        else {
+            return document_predicate(document_id, attributes_.GetStatus(slot), attributes_.GetRating(slot));
+        }
+    }
 
-        ConcurrentMap<int, double> document_to_relevance(16);
-        const auto query = ParseQuery(raw_query);
-        
-        std::for_each(
+    template <typename Accumulate, typename IsExhausted>
+    size_t SearchServer::ForEachPrefixMatch(std::string_view prefix, Accumulate accumulate, IsExhausted is_exhausted) const {
+        struct Cursor {
+            PostingList::const_iterator current;
+            PostingList::const_iterator end;
+            double inverse_document_freq;
+            size_t order;
+        };
+        std::vector<Cursor> cursors;
+        for (const auto* entry : ExpandPrefix(prefix)) {
+            const auto& postings = entry->second;
+            cursors.push_back({ postings.begin(), postings.end(), ComputeInverseDocumentFreq(entry->first, postings.size()), cursors.size() });
+        }
+
+        // k-way merge of the posting lists by document id; equal ids come out in word order,
+        // so the sum does not depend on the heap layout
+        const auto greater_id = [](const Cursor& lhs, const Cursor& rhs) {
+            if (lhs.current->first != rhs.current->first) {
+                return lhs.current->first > rhs.current->first;
+            }
+            return lhs.order > rhs.order;
+        };
+        std::make_heap(cursors.begin(), cursors.end(), greater_id);
+        size_t merged_postings = 0;
+        size_t next_check = POSTING_BLOCK_SIZE;
+        while (!cursors.empty()) {
+            const int document_id = cursors.front().current->first;
+            const int slot = cursors.front().current->second.slot;
+            double relevance = 0.0;
+            while (!cursors.empty() && cursors.front().current->first == document_id) {
+                std::pop_heap(cursors.begin(), cursors.end(), greater_id);
+                Cursor& cursor = cursors.back();
+                relevance += cursor.current->second.term_freq * cursor.inverse_document_freq;
+                ++merged_postings;
+                if (++cursor.current == cursor.end) {
+                    cursors.pop_back();
+                }
+                else {
+                    std::push_heap(cursors.begin(), cursors.end(), greater_id);
+                }
+            }
+            accumulate(document_id, slot, relevance);
+            if (merged_postings >= next_check) {
+                if (is_exhausted(merged_postings)) {
+                    break;
+                }
+                next_check = merged_postings + POSTING_BLOCK_SIZE;
+            }
+        }
+        return merged_postings;
+    }
+
+    inline bool SearchServer::PostingCursor::AdvanceTo(int document_id) {
+        if (seek) {
+            current = postings->lower_bound(document_id);
+        }
+        else {
+            while (current != postings->end() && current->first < document_id) {
+                ++current;
+            }
+        }
+        return current != postings->end() && current->first == document_id;
+    }
+
+    inline bool SearchServer::MinusFilter::Cursor::IsExcluded(int document_id, int slot) {
+        if (bitmap_ != nullptr) {
+            return bitmap_->Test(slot);
+        }
+        bool is_excluded = false;
+        for (PostingCursor& position : positions_) {
+            is_excluded |= position.AdvanceTo(document_id);
+        }
+        return is_excluded;
+    }
+
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> SearchServer::FindAllRequiredDocuments(ExecutionPolicy&& policy, const Query& query,
+        const MinusFilter& minus_filter, const DocumentPredicate& document_predicate) const {
+        auto candidates = IntersectRequiredWords(query, minus_filter);
+        candidates.erase(
+            std::remove_if(candidates.begin(), candidates.end(), [this, &document_predicate](const std::pair<int, int>& candidate) {
+                return !IsAccepted(document_predicate, candidate.first, candidate.second);
+                }),
+            candidates.end());
+
+        using WeightedWords = std::vector<std::pair<std::string_view, double>>;
+        WeightedWords plus_words;
+        for (std::string_view word : query.plus_words) {
+            if (const PostingList* postings = FindPostingList(word)) {
+                plus_words.emplace_back(word, ComputeInverseDocumentFreq(word, postings->size()));
+            }
+        }
+        std::vector<WeightedWords> prefix_expansions;
+        for (std::string_view prefix : query.plus_prefixes) {
+            WeightedWords& expansions = prefix_expansions.emplace_back();
+            for (const auto* entry : ExpandPrefix(prefix)) {
+                expansions.emplace_back(entry->first, ComputeInverseDocumentFreq(entry->first, entry->second.size()));
+            }
+        }
+
+        // Each prefix is summed separately before it is added, like in ForEachPrefixMatch
+        const auto sum_relevance = [](const WordFrequencies& word_freqs, const WeightedWords& words) {
+            double relevance = 0.0;
+            for (const auto& [word, inverse_document_freq] : words) {
+                const auto it = FindWordOrNext(word_freqs, word);
+                if (it != word_freqs.end() && it->first == word) {
+                    relevance += it->second * inverse_document_freq;
+                }
+            }
+            return relevance;
+        };
+
+        std::vector<Document> matched_documents(candidates.size());
+        std::transform(
             policy,
-            query.minus_words.begin(), query.minus_words.end(),
-            [this, &document_to_relevance](std::string_view word) {
-                if (word_to_document_freqs_.count(word)) {
-                    for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                        document_to_relevance.Erase(document_id);
-                    }
+            candidates.begin(), candidates.end(), matched_documents.begin(),
+            [this, &plus_words, &prefix_expansions, &sum_relevance](const std::pair<int, int>& candidate) {
+                const auto& word_freqs = documents_.at(candidate.first).word_freqs;
+                double relevance = sum_relevance(word_freqs, plus_words);
+                for (const WeightedWords& expansions : prefix_expansions) {
+                    relevance += sum_relevance(word_freqs, expansions);
                 }
+                return Document(candidate.first, relevance, attributes_.GetRating(candidate.second));
             });
+        return matched_documents;
+    }
+
+    template <typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+
+        TraceSpan query_span("FindAllDocuments.par"sv);
+        query_span.AddArg("query"sv, raw_query);
+        ConcurrentMap<int, double> document_to_relevance(16);
+        auto query = ParseQuery(raw_query);
+        if (mode == QueryMode::ALL) {
+            query.required_words = query.plus_words;
+        }
+        const MinusFilter minus_filter = BuildMinusFilter(query);
+        if (!minus_filter.IsEmpty()) {
+            query_span.AddArg("exclusion"sv, minus_filter.UsesBitmap() ? "bitmap"sv : "merge"sv);
+        }
+        if (!query.required_words.empty()) {
+            auto matched_documents = FindAllRequiredDocuments(policy, query, minus_filter, document_predicate);
+            query_span.AddArg("matched"sv, matched_documents.size());
+            return matched_documents;
+        }
 
         std::for_each(
             policy,
             query.plus_words.begin(), query.plus_words.end(),
-            [this, &document_predicate, &document_to_relevance](std::string_view word) {
-                if (word_to_document_freqs_.count(word)) {
-                    const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                    for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                        const auto& document_data = documents_.at(document_id);
-                        if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                            document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+            [this, &document_predicate, &document_to_relevance, &minus_filter](std::string_view word) {
+                TraceSpan term_span("term"sv);
+                term_span.AddArg("term"sv, word);
+                if (const PostingList* postings = FindPostingList(word)) {
+                    const double inverse_document_freq = ComputeInverseDocumentFreq(word, postings->size());
+                    term_span.AddArg("postings"sv, postings->size());
+                    auto minus_cursor = minus_filter.MakeCursor(postings->size());
+                    for (const auto& [document_id, posting] : *postings) {
+                        if (!minus_cursor.IsExcluded(document_id, posting.slot) && IsAccepted(document_predicate, document_id, posting.slot)) {
+                            document_to_relevance[document_id].ref_to_value += posting.term_freq * inverse_document_freq;
                         }
                     }
                 }
             }
         );
+
+        std::for_each(
+            policy,
+            query.plus_prefixes.begin(), query.plus_prefixes.end(),
+            [this, &document_predicate, &document_to_relevance, &minus_filter](std::string_view prefix) {
+                TraceSpan prefix_span("prefix"sv);
+                prefix_span.AddArg("prefix"sv, prefix);
+                auto minus_cursor = minus_filter.MakeCursor(GetDocumentCount());
+                ForEachPrefixMatch(prefix, [this, &document_predicate, &document_to_relevance, &minus_cursor](int document_id, int slot, double relevance) {
+                    if (!minus_cursor.IsExcluded(document_id, slot) && IsAccepted(document_predicate, document_id, slot)) {
+                        document_to_relevance[document_id].ref_to_value += relevance;
+                    }
+                    });
+            }
+        );
         std::map<int, double> document_to_relevance_reduced = document_to_relevance.BuildOrdinaryMap();
+        query_span.AddArg("matched"sv, document_to_relevance_reduced.size());
         std::vector<Document> matched_documents;
         matched_documents.reserve(document_to_relevance_reduced.size());
 
         for (const auto [document_id, relevance] : document_to_relevance_reduced) {
-            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+            matched_documents.push_back({ document_id, relevance, attributes_.GetRating(documents_.at(document_id).slot) });
         }
         return matched_documents;
     }
 
 
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentPredicate document_predicate) const {
-        return SearchServer::FindAllDocuments(raw_query, document_predicate);
+    std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+        return SearchServer::FindAllDocuments(raw_query, document_predicate, mode);
+
+    }
 
+    template <typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+        QueryContext& context = GetThreadQueryContext();
+        FindAllDocuments(context, raw_query, document_predicate, mode);
+        return context.documents_;
     }
 
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-        std::map<int, double> document_to_relevance;
-        const auto query = ParseQuery(raw_query);
+    void SearchServer::FindAllDocuments(QueryContext& context, std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode,
+        const QueryBudget& budget) const {
+        TraceSpan query_span("FindAllDocuments"sv);
+        query_span.AddArg("query"sv, raw_query);
+        context.is_approximate_ = false;
+        Query& query = context.query_;
+        ParseQuery(raw_query, context.words_, query);
+        if (mode == QueryMode::ALL) {
+            query.required_words = query.plus_words;
+        }
+        MinusFilter& minus_filter = context.minus_filter_;
+        BuildMinusFilter(query, minus_filter);
+        if (!minus_filter.IsEmpty()) {
+            query_span.AddArg("exclusion"sv, minus_filter.UsesBitmap() ? "bitmap"sv : "merge"sv);
+        }
+        if (!query.required_words.empty()) {
+            context.documents_ = FindAllRequiredDocuments(std::execution::seq, query, minus_filter, document_predicate);
+            query_span.AddArg("matched"sv, context.documents_.size());
+            return;
+        }
+        context.ResetRelevances(attributes_.GetSlotCount());
+        MinusFilter::Cursor& minus_cursor = context.minus_cursor_;
+        // Without a budget the words are summed in sorted order, so the scores do not depend on it
+        const size_t block_size = budget.IsLimited() ? POSTING_BLOCK_SIZE : std::numeric_limits<size_t>::max();
+        if (budget.IsLimited()) {
+            const auto get_inverse_document_freq = [this](std::string_view word) {
+                const PostingList* postings = FindPostingList(word);
+                return postings == nullptr ? -std::numeric_limits<double>::infinity() : ComputeInverseDocumentFreq(word, postings->size());
+            };
+            std::sort(query.plus_words.begin(), query.plus_words.end(), [&get_inverse_document_freq](std::string_view lhs, std::string_view rhs) {
+                const double lhs_inverse_document_freq = get_inverse_document_freq(lhs);
+                const double rhs_inverse_document_freq = get_inverse_document_freq(rhs);
+                if (lhs_inverse_document_freq != rhs_inverse_document_freq) {
+                    return lhs_inverse_document_freq > rhs_inverse_document_freq;
+                }
+                return lhs < rhs;
+                });
+        }
+        size_t scored_postings = 0;
         for (std::string_view word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+            TraceSpan term_span("term"sv);
+            term_span.AddArg("term"sv, word);
+            const PostingList* postings = FindPostingList(word);
+            if (postings == nullptr) {
                 continue;
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            const double inverse_document_freq = ComputeInverseDocumentFreq(word, postings->size());
+            term_span.AddArg("postings"sv, postings->size());
+            minus_filter.ResetCursor(minus_cursor, postings->size());
+            auto posting = postings->begin();
+            while (posting != postings->end() && !context.is_approximate_) {
+                if (budget.IsExhausted(scored_postings)) {
+                    context.is_approximate_ = true;
+                    break;
                 }
+                size_t count = 0;
+                for (; posting != postings->end() && count < block_size; ++posting, ++count) {
+                    const auto& [document_id, document_posting] = *posting;
+                    if (!minus_cursor.IsExcluded(document_id, document_posting.slot) && IsAccepted(document_predicate, document_id, document_posting.slot)) {
+                        context.AddRelevance(document_posting.slot, document_posting.term_freq * inverse_document_freq);
+                    }
+                }
+                scored_postings += count;
             }
         }
 
-        for (auto word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
-            }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+        for (std::string_view prefix : query.plus_prefixes) {
+            if (context.is_approximate_ || budget.IsExhausted(scored_postings)) {
+                context.is_approximate_ = true;
+                break;
             }
+            TraceSpan prefix_span("prefix"sv);
+            prefix_span.AddArg("prefix"sv, prefix);
+            minus_filter.ResetCursor(minus_cursor, GetDocumentCount());
+            const auto accumulate = [this, &document_predicate, &context, &minus_cursor](int document_id, int slot, double relevance) {
+                if (!minus_cursor.IsExcluded(document_id, slot) && IsAccepted(document_predicate, document_id, slot)) {
+                    context.AddRelevance(slot, relevance);
+                }
+            };
+            scored_postings += ForEachPrefixMatch(prefix, accumulate, [&budget, &context, scored_postings](size_t merged_postings) {
+                context.is_approximate_ = budget.IsExhausted(scored_postings + merged_postings);
+                return context.is_approximate_;
+                });
         }
 
-        std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        CollectMatchedDocuments(context);
+        query_span.AddArg("matched"sv, context.documents_.size());
+        if (context.is_approximate_) {
+            query_span.AddArg("approximate"sv, "true"sv);
         }
-        return matched_documents;
-    }
\ No newline at end of file
+    }
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct LoadOptions {
+    string host = "127.0.0.1"s;
+    uint16_t port = 0;
+    int connections = 4;
+    int requests_per_connection = 10'000;
+    int pipeline_depth = 1;
+    int populate = 0;
+    int query_words = 3;
+};
+
+class LineConnection {
+public:
+    LineConnection(const string& host, uint16_t port) {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+        if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            throw runtime_error("connect: "s + strerror(errno));
+        }
+        const int enable = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    }
+
+    LineConnection(const LineConnection&) = delete;
+    LineConnection& operator=(const LineConnection&) = delete;
+
+    ~LineConnection() {
+        close(fd_);
+    }
+
+    void Send(const string& line) {
+        output_ = line;
+        output_.push_back('\n');
+        size_t offset = 0;
+        while (offset < output_.size()) {
+            const ssize_t sent = send(fd_, output_.data() + offset, output_.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                throw runtime_error("send: "s + strerror(errno));
+            }
+            offset += sent;
+        }
+    }
+
+    string ReadLine() {
+        while (true) {
+            const size_t line_end = input_.find('\n');
+            if (line_end != string::npos) {
+                string line = input_.substr(0, line_end);
+                input_.erase(0, line_end + 1);
+                return line;
+            }
+            char buffer[64 * 1024];
+            const ssize_t received = recv(fd_, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                throw runtime_error("connection closed"s);
+            }
+            input_.append(buffer, received);
+        }
+    }
+
+private:
+    int fd_ = -1;
+    string input_;
+    string output_;
+};
+
+vector<string> GenerateDictionary(mt19937& generator, int word_count) {
+    vector<string> words;
+    for (int i = 0; i < word_count; ++i) {
+        string word(uniform_int_distribution(1, 8)(generator), ' ');
+        for (char& c : word) {
+            c = static_cast<char>(uniform_int_distribution<int>('a', 'z')(generator));
+        }
+        words.push_back(move(word));
+    }
+    return words;
+}
+
+string GenerateText(mt19937& generator, const vector<string>& dictionary, int word_count) {
+    string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return text;
+}
+
+// Closed-loop client: keeps pipeline_depth requests in flight on its connection
+void RunConnection(const LoadOptions& options, int seed, const vector<string>& dictionary,
+    vector<int64_t>& latencies_us, int& errors) {
+    mt19937 generator(seed);
+    LineConnection connection(options.host, options.port);
+    deque<Clock::time_point> in_flight;
+    int sent = 0;
+    int received = 0;
+    while (received < options.requests_per_connection) {
+        while (sent < options.requests_per_connection && static_cast<int>(in_flight.size()) < options.pipeline_depth) {
+            connection.Send("SEARCH "s + GenerateText(generator, dictionary, options.query_words));
+            in_flight.push_back(Clock::now());
+            ++sent;
+        }
+        const string response = connection.ReadLine();
+        latencies_us.push_back(chrono::duration_cast<chrono::microseconds>(Clock::now() - in_flight.front()).count());
+        in_flight.pop_front();
+        if (response.rfind("OK"s, 0) != 0) {
+            ++errors;
+        }
+        ++received;
+    }
+}
+
+int64_t Percentile(const vector<int64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    const size_t index = min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+    return sorted[index];
+}
+
+LoadOptions ParseOptions(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const string arg = argv[i];
+        const auto next = [&]() {
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value for "s + arg);
+            }
+            return string(argv[++i]);
+        };
+        if (arg == "--host"s) {
+            options.host = next();
+        }
+        else if (arg == "--port"s) {
+            options.port = static_cast<uint16_t>(stoi(next()));
+        }
+        else if (arg == "--connections"s) {
+            options.connections = stoi(next());
+        }
+        else if (arg == "--requests"s) {
+            options.requests_per_connection = stoi(next());
+        }
+        else if (arg == "--pipeline"s) {
+            options.pipeline_depth = max(1, stoi(next()));
+        }
+        else if (arg == "--populate"s) {
+            options.populate = stoi(next());
+        }
+        else if (arg == "--query-words"s) {
+            options.query_words = stoi(next());
+        }
+        else {
+            throw invalid_argument("Unknown option "s + arg);
+        }
+    }
+    if (options.port == 0) {
+        throw invalid_argument("--port is required"s);
+    }
+    return options;
+}
+
+}  // namespace
+
+// Usage: load_client --port N [--host H] [--connections C] [--requests R]
+//                    [--pipeline D] [--populate DOCS] [--query-words W]
+int main(int argc, char* argv[]) {
+    try {
+        const LoadOptions options = ParseOptions(argc, argv);
+        mt19937 generator;
+        const auto dictionary = GenerateDictionary(generator, 2000);
+
+        if (options.populate > 0) {
+            LineConnection connection(options.host, options.port);
+            for (int id = 0; id < options.populate; ++id) {
+                connection.Send("ADD "s + to_string(id) + " 0 1,2,3 "s + GenerateText(generator, dictionary, 50));
+                connection.ReadLine();
+            }
+        }
+
+        vector<vector<int64_t>> latencies(options.connections);
+        vector<int> errors(options.connections);
+        vector<thread> threads;
+        const auto start = Clock::now();
+        for (int i = 0; i < options.connections; ++i) {
+            latencies[i].reserve(options.requests_per_connection);
+            threads.emplace_back([&, i] {
+                try {
+                    RunConnection(options, i + 1, dictionary, latencies[i], errors[i]);
+                }
+                catch (const exception& e) {
+                    cerr << "load_client: connection "s << i << ": "s << e.what() << endl;
+                    ++errors[i];
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        const double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+        vector<int64_t> all;
+        for (const auto& connection_latencies : latencies) {
+            all.insert(all.end(), connection_latencies.begin(), connection_latencies.end());
+        }
+        sort(all.begin(), all.end());
+        int total_errors = 0;
+        for (int e : errors) {
+            total_errors += e;
+        }
+
+        cout << "requests: "s << all.size() << ", errors: "s << total_errors << endl;
+        cout << "throughput: "s << static_cast<int64_t>(all.size() / seconds) << " req/s"s << endl;
+        cout << "latency us: p50 = "s << Percentile(all, 0.50)
+            << ", p90 = "s << Percentile(all, 0.90)
+            << ", p99 = "s << Percentile(all, 0.99)
+            << ", max = "s << (all.empty() ? 0 : all.back()) << endl;
+    }
+    catch (const exception& e) {
+        cerr << "load_client: "s << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
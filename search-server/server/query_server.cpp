@@ -0,0 +1,396 @@
+#include "query_server.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <execution>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../field_parsing.h"
+
+using namespace std;
+
+namespace {
+
+const int MAX_EVENTS = 64;
+const size_t READ_CHUNK_SIZE = 64 * 1024;
+
+[[noreturn]] void ThrowSystemError(const string& what) {
+    throw runtime_error(what + ": "s + strerror(errno));
+}
+
+void SetNonBlocking(int fd) {
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        ThrowSystemError("fcntl"s);
+    }
+}
+
+string_view NextToken(string_view& text) {
+    const size_t space = text.find(' ');
+    const string_view token = text.substr(0, space);
+    text.remove_prefix(space == text.npos ? text.size() : space + 1);
+    return token;
+}
+
+template <typename Number>
+void AppendNumber(string& out, Number value) {
+    char buffer[32];
+    const auto result = to_chars(begin(buffer), end(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+}  // namespace
+
+QueryServer::QueryServer(SearchServer& search_server, const QueryServerOptions& options)
+    : search_server_(search_server)
+    , options_(options) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        ThrowSystemError("socket"s);
+    }
+    const int enable = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options_.port);
+    if (inet_pton(AF_INET, options_.host.c_str(), &address.sin_addr) != 1) {
+        close(listen_fd_);
+        throw invalid_argument("Invalid host "s + options_.host);
+    }
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+        || listen(listen_fd_, SOMAXCONN) < 0) {
+        const int error = errno;
+        close(listen_fd_);
+        errno = error;
+        ThrowSystemError("bind"s);
+    }
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    SetNonBlocking(listen_fd_);
+
+    epoll_fd_ = epoll_create1(0);
+    stop_fd_ = eventfd(0, EFD_NONBLOCK);
+    if (epoll_fd_ < 0 || stop_fd_ < 0) {
+        ThrowSystemError("epoll"s);
+    }
+    for (int fd : { listen_fd_, stop_fd_ }) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+QueryServer::~QueryServer() {
+    for (const auto& [fd, _] : connections_) {
+        close(fd);
+    }
+    for (int fd : { listen_fd_, epoll_fd_, stop_fd_ }) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+uint16_t QueryServer::GetPort() const {
+    return port_;
+}
+
+void QueryServer::Stop() {
+    const uint64_t value = 1;
+    [[maybe_unused]] const auto written = write(stop_fd_, &value, sizeof(value));
+}
+
+void QueryServer::Run() {
+    epoll_event events[MAX_EVENTS];
+    while (true) {
+        // Lines left over from a capped batch are served without waiting for new input
+        const int timeout = HasPendingRequests() ? 0 : -1;
+        const int count = epoll_wait(epoll_fd_, events, MAX_EVENTS, timeout);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ThrowSystemError("epoll_wait"s);
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == stop_fd_) {
+                return;
+            }
+            if (fd == listen_fd_) {
+                AcceptConnections();
+                continue;
+            }
+            const auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            Connection& connection = it->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                CloseConnection(fd);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !WriteConnection(connection)) {
+                CloseConnection(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                ReadConnection(connection);
+            }
+        }
+
+        CollectBatch();
+        ExecuteBatch();
+
+        vector<int> closed;
+        for (auto& [fd, connection] : connections_) {
+            // Answering the requests before an overlong line may leave it alone in a full buffer
+            SkipOverlongLine(connection);
+            if (!WriteConnection(connection)) {
+                closed.push_back(fd);
+                continue;
+            }
+            // The peer has shut down its side and everything it sent is answered
+            if (connection.peer_closed && connection.output_offset == connection.output.size()
+                && connection.input.find('\n', connection.input_offset) == string::npos) {
+                closed.push_back(fd);
+                continue;
+            }
+            UpdateEvents(connection);
+        }
+        for (int fd : closed) {
+            CloseConnection(fd);
+        }
+    }
+}
+
+void QueryServer::AcceptConnections() {
+    while (true) {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        SetNonBlocking(fd);
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        Connection& connection = connections_[fd];
+        connection.fd = fd;
+        connection.events = EPOLLIN;
+        epoll_event event{};
+        event.events = connection.events;
+        event.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void QueryServer::ReadConnection(Connection& connection) {
+    while (!connection.peer_closed && connection.input.size() - connection.input_offset < options_.max_connection_buffer) {
+        const size_t old_size = connection.input.size();
+        connection.input.resize(old_size + READ_CHUNK_SIZE);
+        const ssize_t received = read(connection.fd, connection.input.data() + old_size, READ_CHUNK_SIZE);
+        connection.input.resize(old_size + max<ssize_t>(received, 0));
+        if (received > 0) {
+            SkipOverlongLine(connection);
+            continue;
+        }
+        if (received == 0) {
+            // Half-closed: answer what was received, then close
+            connection.peer_closed = true;
+        }
+        return;
+    }
+}
+
+void QueryServer::SkipOverlongLine(Connection& connection) {
+    if (connection.is_skipping_line) {
+        const size_t line_end = connection.input.find('\n', connection.input_offset);
+        connection.input.erase(connection.input_offset, line_end == string::npos ? string::npos : line_end + 1 - connection.input_offset);
+        connection.is_skipping_line = line_end == string::npos;
+    }
+    // Without a '\n' in a full buffer every earlier request has been answered,
+    // so the error comes in its place in the order of responses
+    if (connection.input.size() - connection.input_offset >= options_.max_connection_buffer
+        && connection.input.find('\n', connection.input_offset) == string::npos) {
+        connection.output += "ERR line too long\n"s;
+        connection.input.resize(connection.input_offset);
+        connection.is_skipping_line = true;
+    }
+}
+
+bool QueryServer::WriteConnection(Connection& connection) {
+    while (connection.output_offset < connection.output.size()) {
+        const ssize_t sent = send(connection.fd, connection.output.data() + connection.output_offset,
+            connection.output.size() - connection.output_offset, MSG_NOSIGNAL);
+        if (sent < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        connection.output_offset += sent;
+    }
+    // Keep the capacity for the next responses
+    connection.output.clear();
+    connection.output_offset = 0;
+    return true;
+}
+
+void QueryServer::CloseConnection(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
+
+void QueryServer::UpdateEvents(Connection& connection) {
+    uint32_t events = 0;
+    if (!connection.peer_closed
+        && connection.input.size() - connection.input_offset < options_.max_connection_buffer
+        && connection.output.size() - connection.output_offset < options_.max_connection_buffer) {
+        events |= EPOLLIN;
+    }
+    if (connection.output_offset < connection.output.size()) {
+        events |= EPOLLOUT;
+    }
+    if (events == connection.events) {
+        return;
+    }
+    connection.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+bool QueryServer::HasPendingRequests() const {
+    return any_of(connections_.begin(), connections_.end(), [this](const auto& item) {
+        const Connection& connection = item.second;
+        return connection.output.size() - connection.output_offset < options_.max_connection_buffer
+            && connection.input.find('\n', connection.input_offset) != string::npos;
+        });
+}
+
+void QueryServer::CollectBatch() {
+    batch_.clear();
+    for (auto& [fd, connection] : connections_) {
+        if (connection.output.size() - connection.output_offset >= options_.max_connection_buffer) {
+            continue;
+        }
+        for (size_t taken = 0; taken < options_.max_requests_per_connection && batch_.size() < options_.max_batch_size; ++taken) {
+            const size_t line_end = connection.input.find('\n', connection.input_offset);
+            if (line_end == string::npos) {
+                break;
+            }
+            string_view line = string_view(connection.input).substr(connection.input_offset, line_end - connection.input_offset);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            connection.input_offset = line_end + 1;
+            batch_.push_back({ &connection, line, {} });
+        }
+    }
+}
+
+void QueryServer::ExecuteBatch() {
+    size_t begin = 0;
+    while (begin < batch_.size()) {
+        if (!IsReadRequest(batch_[begin].line)) {
+            batch_[begin].response = ExecuteWriteRequest(batch_[begin].line);
+            ++begin;
+            continue;
+        }
+        size_t end = begin;
+        while (end < batch_.size() && IsReadRequest(batch_[end].line)) {
+            ++end;
+        }
+        for_each(
+            execution::par,
+            batch_.begin() + begin, batch_.begin() + end,
+            [this](Request& request) {
+                request.response = ExecuteReadRequest(request.line);
+            });
+        begin = end;
+    }
+
+    for (Request& request : batch_) {
+        request.connection->output += request.response;
+        request.connection->output.push_back('\n');
+    }
+    // Request lines point into the input buffers, so they are compacted only now
+    for (auto& [fd, connection] : connections_) {
+        connection.input.erase(0, connection.input_offset);
+        connection.input_offset = 0;
+    }
+    batch_.clear();
+}
+
+bool QueryServer::IsReadRequest(string_view line) {
+    const string_view command = NextToken(line);
+    return command == "SEARCH"sv || command == "MATCH"sv;
+}
+
+string QueryServer::ExecuteReadRequest(string_view line) const {
+    string response;
+    try {
+        const string_view command = NextToken(line);
+        if (command == "SEARCH"sv) {
+            const auto documents = search_server_.FindTopDocuments(line);
+            response = "OK "s;
+            AppendNumber(response, documents.size());
+            for (const Document& document : documents) {
+                response.push_back(' ');
+                AppendNumber(response, document.id);
+                response.push_back(' ');
+                AppendNumber(response, document.relevance);
+                response.push_back(' ');
+                AppendNumber(response, document.rating);
+            }
+        }
+        else {
+            const int document_id = ParseInt(NextToken(line));
+            const auto [words, status] = search_server_.MatchDocument(line, document_id);
+            response = "OK "s;
+            AppendNumber(response, static_cast<int>(status));
+            for (string_view word : words) {
+                response.push_back(' ');
+                response += word;
+            }
+        }
+    }
+    catch (const exception& e) {
+        response = "ERR "s + e.what();
+    }
+    return response;
+}
+
+string QueryServer::ExecuteWriteRequest(string_view line) {
+    try {
+        const string_view command = NextToken(line);
+        if (command == "ADD"sv) {
+            const int document_id = ParseInt(NextToken(line));
+            const DocumentStatus status = ParseStatus(NextToken(line));
+            const vector<int> ratings = ParseRatings(NextToken(line));
+            search_server_.AddDocument(document_id, line, status, ratings);
+        }
+        else if (command == "REMOVE"sv) {
+            search_server_.RemoveDocument(ParseInt(line));
+        }
+        else {
+            return "ERR Unknown command "s + string(command);
+        }
+    }
+    catch (const exception& e) {
+        return "ERR "s + e.what();
+    }
+    return "OK"s;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../search_server.h"
+
+// Line protocol, one request per '\n'-terminated line:
+//
+//   SEARCH <query>                          -> OK <count> [<id> <relevance> <rating>]...
+//   MATCH <id> <query>                      -> OK <status> [<word>]...
+//   ADD <id> <status> <rating,...> <text>   -> OK
+//   REMOVE <id>                             -> OK
+//
+// The fields of ADD are read as in LoadDocuments: the status is a number or
+// a name, and the ratings may be "-".
+// Any failure is answered with "ERR <message>". Responses on a connection
+// come in the order of its requests. A line that does not fit in
+// max_connection_buffer is answered with "ERR line too long" and skipped.
+struct QueryServerOptions {
+    // 0 picks a free port, see QueryServer::GetPort()
+    uint16_t port = 0;
+    std::string host = "127.0.0.1";
+    // Requests executed in one batch across all connections
+    size_t max_batch_size = 256;
+    // Requests taken from one connection per batch
+    size_t max_requests_per_connection = 32;
+    // A connection is not read while this much input or output is pending
+    size_t max_connection_buffer = 1 << 20;
+};
+
+// Non-blocking TCP front end for SearchServer built on epoll.
+// Requests arriving together are executed as one batch: read-only requests
+// run in parallel like ProcessQueries, ADD and REMOVE run one by one in order.
+class QueryServer {
+public:
+    QueryServer(SearchServer& search_server, const QueryServerOptions& options = {});
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    ~QueryServer();
+
+    uint16_t GetPort() const;
+
+    // Serves connections until Stop() is called
+    void Run();
+
+    // May be called from any thread or a signal handler
+    void Stop();
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        size_t input_offset = 0;
+        std::string output;
+        size_t output_offset = 0;
+        uint32_t events = 0;
+        bool peer_closed = false;
+        // The rest of an overlong line is dropped as it arrives
+        bool is_skipping_line = false;
+    };
+
+    struct Request {
+        Connection* connection;
+        std::string_view line;
+        std::string response;
+    };
+
+    void AcceptConnections();
+
+    void ReadConnection(Connection& connection);
+
+    // Answers a line that fills the whole input buffer with an error and drops it up to its '\n'
+    void SkipOverlongLine(Connection& connection);
+
+    bool WriteConnection(Connection& connection);
+
+    void CloseConnection(int fd);
+
+    void UpdateEvents(Connection& connection);
+
+    bool HasPendingRequests() const;
+
+    void CollectBatch();
+
+    void ExecuteBatch();
+
+    std::string ExecuteReadRequest(std::string_view line) const;
+
+    std::string ExecuteWriteRequest(std::string_view line);
+
+    static bool IsReadRequest(std::string_view line);
+
+    SearchServer& search_server_;
+    QueryServerOptions options_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int stop_fd_ = -1;
+    uint16_t port_ = 0;
+    std::map<int, Connection> connections_;
+    std::vector<Request> batch_;
+};
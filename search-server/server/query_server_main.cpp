@@ -0,0 +1,65 @@
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../document_loader.h"
+#include "query_server.h"
+
+using namespace std;
+
+namespace {
+
+QueryServer* running_server = nullptr;
+
+void HandleSignal(int) {
+    if (running_server != nullptr) {
+        running_server->Stop();
+    }
+}
+
+}  // namespace
+
+// Usage: query_server [port] [stop words] [documents.tsv, "-" for stdin] [document store file]
+int main(int argc, char* argv[]) {
+    QueryServerOptions options;
+    if (argc > 1) {
+        options.port = static_cast<uint16_t>(atoi(argv[1]));
+    }
+    const string stop_words = argc > 2 ? argv[2] : ""s;
+
+    try {
+        SearchServer search_server(stop_words);
+        if (argc > 4) {
+            search_server.SetDocumentStore(make_shared<DocumentStore>(argv[4]));
+        }
+        if (argc > 3) {
+            DocumentLoaderOptions loader_options;
+            loader_options.on_progress = [](const LoadReport& report) {
+                cerr << "Loaded "s << report.document_count << " documents, "s
+                    << report.bytes_read / (1 << 20) << " MiB"s << endl;
+            };
+            const LoadReport report = LoadDocumentsFromFile(search_server, argv[3], loader_options);
+            for (const LoadError& error : report.errors) {
+                cerr << argv[3] << ':' << error.line_number << ": "s << error.message << endl;
+            }
+            if (report.error_count > report.errors.size()) {
+                cerr << report.error_count - report.errors.size() << " more errors"s << endl;
+            }
+        }
+        QueryServer server(search_server, options);
+        running_server = &server;
+        signal(SIGINT, HandleSignal);
+        signal(SIGTERM, HandleSignal);
+
+        cout << "Listening on "s << options.host << ':' << server.GetPort() << endl;
+        server.Run();
+        running_server = nullptr;
+    }
+    catch (const exception& e) {
+        cerr << "query_server: "s << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "sharded_search_server.h"
+
+#include <functional>
+
+using namespace std;
+
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const string& stop_words_text)
+    : ShardedSearchServer(shard_count, SplitIntoWords(stop_words_text)) {
+}
+
+void ShardedSearchServer::CreateShards(size_t shard_count) {
+    if (shard_count == 0) {
+        throw invalid_argument("Shard count must be positive"s);
+    }
+    shards_.reserve(shard_count);
+    for (size_t index = 0; index < shard_count; ++index) {
+        shards_.emplace_back(stop_words_);
+        shards_.back().SetCorpusStatistics(corpus_statistics_.get());
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    // A document id always maps to the same shard, so the shard rejects duplicates itself
+    SearchServer& shard = shards_[GetShardIndex(document_id)];
+    shard.AddDocument(document_id, document, status, ratings);
+
+    auto& document_freqs = corpus_statistics_->document_freqs;
+    for (const auto& [word, _] : shard.GetWordFrequencies(document_id)) {
+        const auto it = document_freqs.find(word);
+        if (it == document_freqs.end()) {
+            document_freqs.emplace(string(word), 1);
+        }
+        else {
+            ++it->second;
+        }
+    }
+    ++corpus_statistics_->document_count;
+    ++corpus_statistics_->version;
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    SearchServer& shard = shards_[GetShardIndex(document_id)];
+    const int shard_document_count = shard.GetDocumentCount();
+    vector<string> words;
+    for (const auto& [word, _] : shard.GetWordFrequencies(document_id)) {
+        words.emplace_back(word);
+    }
+    shard.RemoveDocument(document_id);
+    if (shard.GetDocumentCount() == shard_document_count) {
+        return;
+    }
+
+    auto& document_freqs = corpus_statistics_->document_freqs;
+    for (const string& word : words) {
+        const auto it = document_freqs.find(word);
+        if (--it->second == 0) {
+            document_freqs.erase(it);
+        }
+    }
+    --corpus_statistics_->document_count;
+    ++corpus_statistics_->version;
+}
+
+void ShardedSearchServer::SetDocumentStatus(int document_id, DocumentStatus status) {
+    shards_[GetShardIndex(document_id)].SetDocumentStatus(document_id, status);
+}
+
+void ShardedSearchServer::SetDocumentRating(int document_id, const vector<int>& ratings) {
+    shards_[GetShardIndex(document_id)].SetDocumentRating(document_id, ratings);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status, QueryMode mode) const {
+    return FindTopDocuments(raw_query, StatusFilter{ status }, mode);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query, QueryMode mode) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL, mode);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+tuple<vector<string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    return shards_[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+}
+
+const SearchServer::WordFrequencies& ShardedSearchServer::GetWordFrequencies(int document_id) const {
+    return shards_[GetShardIndex(document_id)].GetWordFrequencies(document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    return corpus_statistics_->document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t index) const {
+    return shards_.at(index);
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    return hash<int>{}(document_id) % shards_.size();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+// Splits documents between several SearchServer shards by document id.
+// Queries run on all shards in parallel and the per-shard top documents are merged.
+// The shards share CorpusStatistics, so relevance matches a single SearchServer
+// holding all documents (tests/sharded_search_server_test.cpp checks it). A prefix
+// is expanded against the words of the shared statistics, so every shard scores
+// the same MAX_PREFIX_EXPANSIONS words as a single server would.
+// The shards live in the same process; running them as separate processes
+// is not done yet, see README.
+class ShardedSearchServer {
+public:
+    template <typename StringContainer>
+    ShardedSearchServer(size_t shard_count, const StringContainer& stop_words);
+
+    ShardedSearchServer(size_t shard_count, const std::string& stop_words_text);
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    void SetDocumentStatus(int document_id, DocumentStatus status);
+
+    void SetDocumentRating(int document_id, const std::vector<int>& ratings);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode = QueryMode::ANY) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, QueryMode mode = QueryMode::ANY) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, QueryMode mode) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus>
+        MatchDocument(std::string_view raw_query, int document_id) const;
+
+    const SearchServer::WordFrequencies& GetWordFrequencies(int document_id) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+    const SearchServer& GetShard(size_t index) const;
+
+private:
+    size_t GetShardIndex(int document_id) const;
+
+    void CreateShards(size_t shard_count);
+
+    std::vector<std::string> stop_words_;
+    std::unique_ptr<CorpusStatistics> corpus_statistics_;
+    std::vector<SearchServer> shards_;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const StringContainer& stop_words)
+    : stop_words_(std::begin(stop_words), std::end(stop_words))
+    , corpus_statistics_(std::make_unique<CorpusStatistics>())
+{
+    CreateShards(shard_count);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, QueryMode mode) const {
+    std::vector<std::vector<Document>> shard_results(shards_.size());
+    std::vector<std::exception_ptr> shard_errors(shards_.size());
+    std::vector<size_t> indexes(shards_.size());
+    for (size_t index = 0; index < indexes.size(); ++index) {
+        indexes[index] = index;
+    }
+
+    // Exceptions must not escape a parallel algorithm, so they are rethrown afterwards
+    std::for_each(
+        std::execution::par,
+        indexes.begin(), indexes.end(),
+        [this, raw_query, &document_predicate, mode, &shard_results, &shard_errors](size_t index) {
+            try {
+                shard_results[index] = shards_[index].FindTopDocuments(raw_query, document_predicate, mode);
+            }
+            catch (...) {
+                shard_errors[index] = std::current_exception();
+            }
+        });
+    for (const auto& error : shard_errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    for (auto& documents : shard_results) {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+    }
+    std::sort(matched_documents.begin(), matched_documents.end(), IsMoreRelevant);
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return matched_documents;
+}
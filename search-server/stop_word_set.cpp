@@ -0,0 +1,27 @@
+#include "stop_word_set.h"
+
+using namespace std;
+
+void StopWordSet::Build() {
+    displacements_.assign(stop_words_detail::GetBucketCount(words_.size()), 0);
+    slots_.assign(stop_words_detail::GetSlotCount(words_.size()), 0);
+    vector<uint64_t> hashes;
+    hashes.reserve(words_.size());
+    for (const string& word : words_) {
+        hashes.push_back(stop_words_detail::HashWord(word));
+    }
+    vector<size_t> order(words_.size());
+    vector<size_t> bucket_starts(displacements_.size() + 1);
+    if (!stop_words_detail::BuildPerfectHash(hashes, words_.size(), displacements_, displacements_.size(), slots_, slots_.size(),
+        order, bucket_starts)) {
+        throw invalid_argument("Can't build a perfect hash of stop words"s);
+    }
+    UpdateLengthMask();
+}
+
+void StopWordSet::UpdateLengthMask() {
+    length_mask_ = 0;
+    for (const string& word : words_) {
+        length_mask_ |= uint64_t{ 1 } << (word.size() < 63 ? word.size() : 63);
+    }
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Perfect hashing of stop words in the CHD (hash and displace) style:
+// the words are split into buckets by one hash, and every bucket gets the
+// smallest displacement that sends all its words to free slots. A lookup is
+// one hash of the word, two table reads and one comparison.
+namespace stop_words_detail {
+
+constexpr uint64_t HashWord(std::string_view word) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : word) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+constexpr uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+constexpr size_t GetBucket(uint64_t hash, size_t bucket_count) {
+    return Mix(hash) % bucket_count;
+}
+
+constexpr size_t GetSlot(uint64_t hash, uint32_t displacement, size_t slot_count) {
+    return Mix(hash ^ ((displacement + 1) * 0x9e3779b97f4a7c15ull)) % slot_count;
+}
+
+constexpr size_t GetSlotCount(size_t word_count) {
+    return word_count + word_count / 4 + 1;
+}
+
+constexpr size_t GetBucketCount(size_t word_count) {
+    return word_count / 4 + 1;
+}
+
+constexpr bool IsValidStopWord(std::string_view word) {
+    for (char c : word) {
+        if (c >= '\0' && c < ' ') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fills slots with indexes of words plus one (0 is a free slot) given the HashWord
+// of every word; returns false if some bucket can't be placed. Words must be unique.
+// order and bucket_starts are scratch space of word_count and bucket_count + 1 entries.
+template <typename Hashes, typename Displacements, typename Slots, typename Order, typename BucketStarts>
+constexpr bool BuildPerfectHash(const Hashes& hashes, size_t word_count, Displacements& displacements, size_t bucket_count,
+    Slots& slots, size_t slot_count, Order& order, BucketStarts& bucket_starts) {
+    const uint32_t MAX_DISPLACEMENT = 1 << 20;
+
+    // Words grouped by bucket with a counting sort: the words of bucket b are
+    // order[bucket_starts[b]] up to order[bucket_starts[b + 1]]
+    for (size_t bucket = 0; bucket <= bucket_count; ++bucket) {
+        bucket_starts[bucket] = 0;
+    }
+    for (size_t i = 0; i < word_count; ++i) {
+        ++bucket_starts[GetBucket(hashes[i], bucket_count) + 1];
+    }
+    size_t max_bucket_size = 0;
+    for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+        max_bucket_size = bucket_starts[bucket + 1] > max_bucket_size ? bucket_starts[bucket + 1] : max_bucket_size;
+        bucket_starts[bucket + 1] += bucket_starts[bucket];
+    }
+    for (size_t i = 0; i < word_count; ++i) {
+        order[bucket_starts[GetBucket(hashes[i], bucket_count)]++] = i;
+    }
+    // Every start has moved to the start of the next bucket
+    for (size_t bucket = bucket_count; bucket > 0; --bucket) {
+        bucket_starts[bucket] = bucket_starts[bucket - 1];
+    }
+    bucket_starts[0] = 0;
+
+    // Larger buckets are the hardest to place, so they go first
+    for (size_t bucket_size = max_bucket_size; bucket_size > 0; --bucket_size) {
+        for (size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            const size_t begin = bucket_starts[bucket];
+            const size_t end = bucket_starts[bucket + 1];
+            if (end - begin != bucket_size) {
+                continue;
+            }
+
+            bool is_placed = false;
+            for (uint32_t displacement = 0; displacement < MAX_DISPLACEMENT; ++displacement) {
+                size_t placed_end = begin;
+                while (placed_end < end) {
+                    const size_t slot = GetSlot(hashes[order[placed_end]], displacement, slot_count);
+                    if (slots[slot] != 0) {
+                        break;
+                    }
+                    slots[slot] = static_cast<uint32_t>(order[placed_end] + 1);
+                    ++placed_end;
+                }
+                is_placed = placed_end == end;
+                if (is_placed) {
+                    displacements[bucket] = displacement;
+                    break;
+                }
+                // Free the slots taken with this displacement
+                for (size_t i = begin; i < placed_end; ++i) {
+                    slots[GetSlot(hashes[order[i]], displacement, slot_count)] = 0;
+                }
+            }
+            if (!is_placed) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace stop_words_detail
+
+// Stop words hashed at compile time:
+//
+//   constexpr auto STOP_WORDS = MakeStopWordTable(std::array{ "a"sv, "and"sv, "in"sv });
+//   SearchServer search_server(STOP_WORDS);
+//
+// Empty and repeated words are dropped like MakeUniqueNonEmptyStrings does;
+// an invalid word fails the compilation. The work grows linearly with N, and
+// GCC's default -fconstexpr-ops-limit lets about 10000 words through; a larger
+// set should go to the run-time constructors of SearchServer instead.
+template <size_t N>
+struct StopWordTable {
+    static constexpr size_t SLOT_COUNT = stop_words_detail::GetSlotCount(N);
+    static constexpr size_t BUCKET_COUNT = stop_words_detail::GetBucketCount(N);
+
+    std::array<std::string_view, N> words{};
+    size_t word_count = 0;
+    std::array<uint32_t, BUCKET_COUNT> displacements{};
+    std::array<uint32_t, SLOT_COUNT> slots{};
+};
+
+template <size_t N>
+constexpr StopWordTable<N> MakeStopWordTable(const std::array<std::string_view, N>& words) {
+    StopWordTable<N> table;
+    std::array<uint64_t, N> hashes{};
+    // Open addressing by hash finds the repeated words without comparing every pair
+    std::array<size_t, 2 * N + 1> known_words{};
+    for (std::string_view word : words) {
+        if (!stop_words_detail::IsValidStopWord(word)) {
+            throw std::invalid_argument("Some of stop words are invalid");
+        }
+        if (word.empty()) {
+            continue;
+        }
+        const uint64_t hash = stop_words_detail::HashWord(word);
+        size_t position = stop_words_detail::Mix(hash) % known_words.size();
+        bool is_repeated = false;
+        while (!is_repeated && known_words[position] != 0) {
+            const size_t index = known_words[position] - 1;
+            is_repeated = hashes[index] == hash && table.words[index] == word;
+            position = (position + 1) % known_words.size();
+        }
+        if (!is_repeated) {
+            known_words[position] = table.word_count + 1;
+            hashes[table.word_count] = hash;
+            table.words[table.word_count++] = word;
+        }
+    }
+    std::array<size_t, N> order{};
+    std::array<size_t, StopWordTable<N>::BUCKET_COUNT + 1> bucket_starts{};
+    if (!stop_words_detail::BuildPerfectHash(hashes, table.word_count, table.displacements, table.BUCKET_COUNT,
+        table.slots, table.SLOT_COUNT, order, bucket_starts)) {
+        throw std::invalid_argument("Can't build a perfect hash of stop words");
+    }
+    return table;
+}
+
+// Stop words of a SearchServer. The words are owned by the set, so it does not
+// depend on the container it was built from.
+class StopWordSet {
+public:
+    StopWordSet() = default;
+
+    // Words must be unique and non-empty, as MakeUniqueNonEmptyStrings makes them
+    template <typename StringContainer>
+    explicit StopWordSet(const StringContainer& words);
+
+    template <size_t N>
+    explicit StopWordSet(const StopWordTable<N>& table);
+
+    bool Contains(std::string_view word) const {
+        // A word of a length no stop word has is rejected before hashing
+        if (((length_mask_ >> (word.size() < 63 ? word.size() : 63)) & 1) == 0) {
+            return false;
+        }
+        const uint64_t hash = stop_words_detail::HashWord(word);
+        const uint32_t displacement = displacements_[stop_words_detail::GetBucket(hash, displacements_.size())];
+        const uint32_t index = slots_[stop_words_detail::GetSlot(hash, displacement, slots_.size())];
+        return index != 0 && words_[index - 1] == word;
+    }
+
+    const std::vector<std::string>& GetWords() const {
+        return words_;
+    }
+
+private:
+    void Build();
+
+    void UpdateLengthMask();
+
+    std::vector<std::string> words_;
+    std::vector<uint32_t> displacements_;
+    std::vector<uint32_t> slots_;
+    // Bit i is set if there is a stop word of length i, bit 63 covers longer words
+    uint64_t length_mask_ = 0;
+};
+
+template <typename StringContainer>
+StopWordSet::StopWordSet(const StringContainer& words)
+    : words_(std::begin(words), std::end(words)) {
+    Build();
+}
+
+template <size_t N>
+StopWordSet::StopWordSet(const StopWordTable<N>& table)
+    : words_(table.words.begin(), table.words.begin() + table.word_count)
+    , displacements_(table.displacements.begin(), table.displacements.end())
+    , slots_(table.slots.begin(), table.slots.end()) {
+    UpdateLengthMask();
+}
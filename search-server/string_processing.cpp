@@ -4,6 +4,12 @@ using namespace std;
 
 vector<string_view> SplitIntoWords(string_view str) {
     vector<string_view> result;
+    SplitIntoWords(str, result);
+    return result;
+}
+
+void SplitIntoWords(string_view str, vector<string_view>& result) {
+    result.clear();
     int64_t pos = 0;
     const int64_t pos_end = str.npos;
     while (true) {
@@ -16,5 +22,4 @@ vector<string_view> SplitIntoWords(string_view str) {
             str.remove_prefix(space + 1);
         }
     }
-    return result;
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// Replaces the contents of words, reusing their memory
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+
 template <typename StringContainer>
 std::set<std::string_view, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string_view, std::less<>> non_empty_strings;
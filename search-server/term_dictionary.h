@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Sorted term dictionary with front-coded blocks. Every block starts with
+// a fully stored term, the following terms keep only the suffix that differs
+// from their predecessor. Prefix lookups binary search the block heads and
+// decode forward from there.
+//
+// The owner keeps the dictionary in step with its vocabulary: Insert and Erase
+// re-encode only the block of the term, and a block that grows to twice
+// BLOCK_SIZE terms is split in two. Like the rest of the index, it must not be
+// changed while it is read.
+template <typename Payload>
+class TermDictionary {
+public:
+    size_t GetTermCount() const {
+        return term_count_;
+    }
+
+    // Heap bytes held by the encoded blocks
+    size_t GetMemoryUsage() const {
+        size_t usage = blocks_.capacity() * sizeof(Block);
+        for (const Block& block : blocks_) {
+            usage += block.data.capacity() + block.payloads.capacity() * sizeof(Payload);
+        }
+        return usage;
+    }
+
+    // Replaces the contents with terms sorted without repeats
+    void Build(const std::vector<std::pair<std::string_view, Payload>>& sorted_terms);
+
+    // Adds term or replaces its payload
+    void Insert(std::string_view term, Payload payload);
+
+    void Erase(std::string_view term);
+
+    // Calls callback(term, payload) for at most max_count terms starting with
+    // prefix, in lexicographical order. Returns the number of calls made.
+    template <typename Callback>
+    size_t ForEachWithPrefix(std::string_view prefix, size_t max_count, Callback&& callback) const;
+
+private:
+    static const size_t BLOCK_SIZE = 16;
+
+    struct Block {
+        std::string data;
+        std::vector<Payload> payloads;
+    };
+
+    // Index of the block that holds term or would hold it
+    size_t FindBlock(std::string_view term) const;
+
+    std::string_view GetBlockHead(size_t block) const;
+
+    static void DecodeBlock(const Block& block, std::vector<std::string>& terms);
+
+    static void EncodeBlock(Block& block, const std::vector<std::string>& terms, size_t begin, size_t end);
+
+    static void WriteLength(std::string& out, size_t value);
+
+    static size_t ReadLength(const std::string& in, size_t& pos);
+
+    std::vector<Block> blocks_;
+    size_t term_count_ = 0;
+};
+
+template <typename Payload>
+template <typename Callback>
+size_t TermDictionary<Payload>::ForEachWithPrefix(std::string_view prefix, size_t max_count, Callback&& callback) const {
+    if (blocks_.empty() || max_count == 0) {
+        return 0;
+    }
+
+    // The first term with the prefix lives in the last block whose head is < prefix,
+    // or in the first block at all.
+    size_t left = 0;
+    size_t right = blocks_.size();
+    while (right - left > 1) {
+        const size_t middle = (left + right) / 2;
+        if (GetBlockHead(middle) < prefix) {
+            left = middle;
+        }
+        else {
+            right = middle;
+        }
+    }
+
+    size_t count = 0;
+    std::string term;
+    for (size_t block = left; block < blocks_.size(); ++block) {
+        const Block& current_block = blocks_[block];
+        size_t pos = 0;
+        for (size_t index = 0; index < current_block.payloads.size(); ++index) {
+            const size_t shared = ReadLength(current_block.data, pos);
+            const size_t suffix = ReadLength(current_block.data, pos);
+            term.resize(shared);
+            term.append(current_block.data, pos, suffix);
+            pos += suffix;
+
+            const std::string_view current = term;
+            if (current.substr(0, prefix.size()) == prefix) {
+                callback(current, current_block.payloads[index]);
+                if (++count == max_count) {
+                    return count;
+                }
+            }
+            else if (current > prefix) {
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::Build(const std::vector<std::pair<std::string_view, Payload>>& sorted_terms) {
+    blocks_.clear();
+    term_count_ = sorted_terms.size();
+    std::vector<std::string> terms;
+    for (size_t begin = 0; begin < sorted_terms.size(); begin += BLOCK_SIZE) {
+        const size_t end = std::min(begin + BLOCK_SIZE, sorted_terms.size());
+        Block& block = blocks_.emplace_back();
+        terms.clear();
+        for (size_t index = begin; index < end; ++index) {
+            terms.emplace_back(sorted_terms[index].first);
+            block.payloads.push_back(sorted_terms[index].second);
+        }
+        EncodeBlock(block, terms, 0, terms.size());
+    }
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::Insert(std::string_view term, Payload payload) {
+    if (blocks_.empty()) {
+        blocks_.emplace_back();
+    }
+    const size_t block_index = FindBlock(term);
+    Block& block = blocks_[block_index];
+    std::vector<std::string> terms;
+    DecodeBlock(block, terms);
+    const auto position = std::lower_bound(terms.begin(), terms.end(), term);
+    const size_t index = position - terms.begin();
+    if (position != terms.end() && *position == term) {
+        block.payloads[index] = payload;
+        return;
+    }
+    terms.emplace(position, term);
+    block.payloads.insert(block.payloads.begin() + index, payload);
+    ++term_count_;
+
+    if (terms.size() < 2 * BLOCK_SIZE) {
+        EncodeBlock(block, terms, 0, terms.size());
+        return;
+    }
+    Block second_half;
+    second_half.payloads.assign(block.payloads.begin() + BLOCK_SIZE, block.payloads.end());
+    block.payloads.resize(BLOCK_SIZE);
+    EncodeBlock(block, terms, 0, BLOCK_SIZE);
+    EncodeBlock(second_half, terms, BLOCK_SIZE, terms.size());
+    blocks_.insert(blocks_.begin() + block_index + 1, std::move(second_half));
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::Erase(std::string_view term) {
+    if (blocks_.empty()) {
+        return;
+    }
+    const size_t block_index = FindBlock(term);
+    Block& block = blocks_[block_index];
+    std::vector<std::string> terms;
+    DecodeBlock(block, terms);
+    const auto position = std::lower_bound(terms.begin(), terms.end(), term);
+    if (position == terms.end() || *position != term) {
+        return;
+    }
+    block.payloads.erase(block.payloads.begin() + (position - terms.begin()));
+    terms.erase(position);
+    --term_count_;
+    if (terms.empty()) {
+        blocks_.erase(blocks_.begin() + block_index);
+    }
+    else {
+        EncodeBlock(block, terms, 0, terms.size());
+    }
+}
+
+template <typename Payload>
+size_t TermDictionary<Payload>::FindBlock(std::string_view term) const {
+    // The last block whose head is <= term; a term before every head goes to the first block
+    size_t left = 0;
+    size_t right = blocks_.size();
+    while (right - left > 1) {
+        const size_t middle = (left + right) / 2;
+        if (GetBlockHead(middle) <= term) {
+            left = middle;
+        }
+        else {
+            right = middle;
+        }
+    }
+    return left;
+}
+
+template <typename Payload>
+std::string_view TermDictionary<Payload>::GetBlockHead(size_t block) const {
+    const std::string& data = blocks_[block].data;
+    size_t pos = 0;
+    ReadLength(data, pos);
+    const size_t length = ReadLength(data, pos);
+    return std::string_view(data).substr(pos, length);
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::DecodeBlock(const Block& block, std::vector<std::string>& terms) {
+    terms.clear();
+    terms.reserve(block.payloads.size() + 1);
+    size_t pos = 0;
+    for (size_t index = 0; index < block.payloads.size(); ++index) {
+        const size_t shared = ReadLength(block.data, pos);
+        const size_t suffix = ReadLength(block.data, pos);
+        std::string term = index == 0 ? std::string() : terms.back().substr(0, shared);
+        term.append(block.data, pos, suffix);
+        pos += suffix;
+        terms.push_back(std::move(term));
+    }
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::EncodeBlock(Block& block, const std::vector<std::string>& terms, size_t begin, size_t end) {
+    block.data.clear();
+    for (size_t index = begin; index < end; ++index) {
+        const std::string& term = terms[index];
+        size_t shared = 0;
+        if (index != begin) {
+            const std::string& previous = terms[index - 1];
+            const size_t limit = std::min(previous.size(), term.size());
+            while (shared < limit && previous[shared] == term[shared]) {
+                ++shared;
+            }
+        }
+        WriteLength(block.data, shared);
+        WriteLength(block.data, term.size() - shared);
+        block.data.append(term, shared, std::string::npos);
+    }
+    block.data.shrink_to_fit();
+}
+
+template <typename Payload>
+void TermDictionary<Payload>::WriteLength(std::string& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+template <typename Payload>
+size_t TermDictionary<Payload>::ReadLength(const std::string& in, size_t& pos) {
+    size_t value = 0;
+    int shift = 0;
+    while (true) {
+        const auto byte = static_cast<uint8_t>(in[pos++]);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+        shift += 7;
+    }
+}
@@ -0,0 +1,166 @@
+#include <atomic>
+#include <execution>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../impact_index.h"
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+// The concurrent part is meant for ThreadSanitizer as well: build this check
+// with -fsanitize=thread -g and it must run without reports.
+
+namespace {
+
+struct Attributes {
+    DocumentStatus status;
+    vector<int> ratings;
+};
+
+const int DOCUMENT_COUNT = 2000;
+
+DocumentStatus GenerateStatus(mt19937& generator) {
+    return static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+}
+
+vector<int> GenerateRatings(mt19937& generator) {
+    vector<int> ratings(uniform_int_distribution(1, 3)(generator));
+    for (int& rating : ratings) {
+        rating = uniform_int_distribution(-5, 5)(generator);
+    }
+    return ratings;
+}
+
+// Updating in place must give what removing the document and adding it again gives,
+// in an ImpactIndex built before the updates too
+void TestUpdatesMatchRemoveAndAdd() {
+    mt19937 generator(43);
+    const auto dictionary = GenerateDictionary(generator, 500, 4);
+    vector<string> texts;
+    vector<Attributes> attributes;
+    SearchServer updated(vector<string>{ dictionary[0] });
+    for (int document_id = 0; document_id < DOCUMENT_COUNT; ++document_id) {
+        texts.push_back(GenerateText(generator, dictionary, uniform_int_distribution(1, 30)(generator)));
+        attributes.push_back({ GenerateStatus(generator), GenerateRatings(generator) });
+        updated.AddDocument(document_id, texts.back(), attributes.back().status, attributes.back().ratings);
+    }
+    SearchServer readded = updated;
+    const ImpactIndex impact_index(updated);
+
+    for (int i = 0; i < 3000; ++i) {
+        const int document_id = uniform_int_distribution(0, DOCUMENT_COUNT - 1)(generator);
+        Attributes& document = attributes[document_id];
+        if (i % 2 == 0) {
+            document.status = GenerateStatus(generator);
+            updated.SetDocumentStatus(document_id, document.status);
+        }
+        else {
+            document.ratings = GenerateRatings(generator);
+            updated.SetDocumentRating(document_id, document.ratings);
+        }
+        readded.RemoveDocument(document_id);
+        readded.AddDocument(document_id, texts[document_id], document.status, document.ratings);
+    }
+
+    for (int i = 0; i < 500; ++i) {
+        const string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 8)(generator));
+        const string plain_query = GenerateText(generator, dictionary, uniform_int_distribution(1, 5)(generator));
+        for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            const auto document_status = static_cast<DocumentStatus>(status);
+            CHECK_WITH(AreSameDocuments(updated.FindTopDocuments(execution::seq, query, document_status),
+                readded.FindTopDocuments(execution::seq, query, document_status)), query);
+            CHECK_WITH(AreCloseDocuments(updated.FindTopDocuments(execution::par, query, document_status),
+                readded.FindTopDocuments(execution::par, query, document_status)), query);
+            // The index scores queries of plain words itself and passes the others to the server
+            CHECK_WITH(AreSameDocuments(impact_index.FindTopDocuments(plain_query, document_status),
+                readded.FindTopDocuments(execution::seq, plain_query, document_status)), plain_query);
+        }
+        CHECK_WITH(AreSameDocuments(impact_index.FindTopDocuments(plain_query, RatingRange{ -1, 2 }),
+            readded.FindTopDocuments(execution::seq, plain_query, RatingRange{ -1, 2 })), plain_query);
+        CHECK_WITH(AreSameDocuments(updated.FindTopDocuments(execution::seq, query, RatingRange{ -1, 2 }),
+            readded.FindTopDocuments(execution::seq, query, RatingRange{ -1, 2 })), query);
+        CHECK_WITH(AreCloseDocuments(updated.FindTopDocuments(execution::par, query, RatingRange{ -1, 2 }),
+            readded.FindTopDocuments(execution::par, query, RatingRange{ -1, 2 })), query);
+    }
+
+    for (int document_id = 0; document_id < DOCUMENT_COUNT; document_id += 7) {
+        CHECK(get<1>(updated.MatchDocument(texts[document_id], document_id)) == attributes[document_id].status);
+    }
+    CHECK(impact_index.IsUpToDate());
+}
+
+// One writer updates the even documents while three threads query, one of
+// them through an ImpactIndex. Every
+// rating seen stays in [-5, 5], a BANNED result is always an even document,
+// and afterwards every document has the status written last.
+void TestUpdatesDuringQueries() {
+    mt19937 generator(44);
+    const auto dictionary = GenerateDictionary(generator, 300, 3);
+    vector<string> texts;
+    SearchServer search_server(vector<string>{});
+    for (int document_id = 0; document_id < DOCUMENT_COUNT; ++document_id) {
+        texts.push_back(GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)));
+        search_server.AddDocument(document_id, texts.back(), DocumentStatus::ACTUAL, GenerateRatings(generator));
+    }
+    vector<DocumentStatus> statuses(DOCUMENT_COUNT, DocumentStatus::ACTUAL);
+    const ImpactIndex impact_index(search_server);
+
+    atomic<bool> is_writing = true;
+    atomic<int> failure_count = 0;
+    vector<thread> readers;
+    for (int reader = 0; reader < 3; ++reader) {
+        readers.emplace_back([&, reader] {
+            mt19937 reader_generator(reader);
+            do {
+                const string query = GenerateText(reader_generator, dictionary, 3);
+                const auto actual = reader == 0 ? search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL)
+                    : reader == 1 ? search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL)
+                    : impact_index.FindTopDocuments(query, DocumentStatus::ACTUAL);
+                for (const Document& document : actual) {
+                    if (document.rating < -5 || document.rating > 5) {
+                        ++failure_count;
+                    }
+                }
+                const auto banned = reader == 2 ? impact_index.FindTopDocuments(query, DocumentStatus::BANNED)
+                    : search_server.FindTopDocuments(query, DocumentStatus::BANNED);
+                for (const Document& document : banned) {
+                    if (document.id % 2 == 1 || document.rating < -5 || document.rating > 5) {
+                        ++failure_count;
+                    }
+                }
+            } while (is_writing);
+        });
+    }
+
+    for (int i = 0; i < 20000; ++i) {
+        const int document_id = 2 * uniform_int_distribution(0, DOCUMENT_COUNT / 2 - 1)(generator);
+        if (i % 2 == 0) {
+            statuses[document_id] = i % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+            search_server.SetDocumentStatus(document_id, statuses[document_id]);
+        }
+        else {
+            search_server.SetDocumentRating(document_id, GenerateRatings(generator));
+        }
+    }
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    CHECK(failure_count == 0);
+
+    for (int document_id = 0; document_id < DOCUMENT_COUNT; ++document_id) {
+        CHECK_WITH(get<1>(search_server.MatchDocument(texts[document_id], document_id)) == statuses[document_id], document_id);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestUpdatesMatchRemoveAndAdd();
+    TestUpdatesDuringQueries();
+    return ReportChecks("attribute_updates_test");
+}
@@ -0,0 +1,223 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../document_loader.h"
+#include "../field_parsing.h"
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+const vector<string> STOP_WORDS = { "and"s, "in"s };
+
+// Valid lines mixed with every kind of bad one. The last line has no '\n'.
+string GenerateInput(mt19937& generator, const vector<string>& dictionary, int line_count) {
+    static const vector<string> statuses = { "0"s, "1"s, "2"s, "3"s, "ACTUAL"s, "BANNED"s, "4"s, "-1"s, "actual"s, ""s };
+    static const vector<string> ratings = { "1,2,3"s, "-"s, ""s, "-5"s, "7,-2"s, "1,,2"s, "x"s };
+    string input;
+    for (int i = 0; i < line_count; ++i) {
+        string id = to_string(uniform_int_distribution(-2, line_count)(generator));
+        switch (uniform_int_distribution(0, 19)(generator)) {
+        case 0:
+            input += '\n';
+            continue;
+        case 1:
+            input += id + "\tACTUAL\t1 no fourth field\n"s;
+            continue;
+        case 2:
+            id += 'x';
+            break;
+        case 3:
+            // Longer than the chunks of the small chunk test
+            input += id + "\t0\t1\t"s + GenerateText(generator, dictionary, 300) + '\n';
+            continue;
+        }
+        input += id + '\t' + statuses[uniform_int_distribution<size_t>(0, statuses.size() - 1)(generator)]
+            + '\t' + ratings[uniform_int_distribution<size_t>(0, ratings.size() - 1)(generator)]
+            + '\t' + GenerateText(generator, dictionary, uniform_int_distribution(0, 12)(generator))
+            + (i % 7 == 0 ? " and\t in\r\n"s : "\n"s);
+    }
+    input += "999999\tBANNED\t4\ttrailing line without newline"s;
+    return input;
+}
+
+// What LoadDocuments must do: each line parsed and passed to AddDocument in turn
+LoadReport LoadLineByLine(SearchServer& search_server, const string& input) {
+    LoadReport report;
+    report.bytes_read = input.size();
+    size_t line_number = 0;
+    for (size_t begin = 0; begin < input.size();) {
+        size_t end = input.find('\n', begin);
+        end = end == string::npos ? input.size() : end;
+        string_view line = string_view(input).substr(begin, end - begin);
+        begin = end + 1;
+        ++line_number;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+        try {
+            vector<string_view> fields;
+            for (int field = 0; field < 3; ++field) {
+                const size_t tab = line.find('\t');
+                if (tab == line.npos) {
+                    throw invalid_argument("Expected 4 tab-separated fields"s);
+                }
+                fields.push_back(line.substr(0, tab));
+                line.remove_prefix(tab + 1);
+            }
+            const int document_id = ParseInt(fields[0]);
+            const DocumentStatus status = ParseStatus(fields[1]);
+            search_server.AddDocument(document_id, line, status, ParseRatings(fields[2]));
+            ++report.document_count;
+        }
+        catch (const invalid_argument& e) {
+            report.errors.push_back({ line_number, e.what() });
+        }
+    }
+    report.line_count = line_number;
+    report.error_count = report.errors.size();
+    return report;
+}
+
+void CheckSameReport(const LoadReport& actual, const LoadReport& expected, size_t max_reported_errors) {
+    CHECK_WITH(actual.bytes_read == expected.bytes_read, actual.bytes_read << " vs " << expected.bytes_read);
+    CHECK_WITH(actual.line_count == expected.line_count, actual.line_count << " vs " << expected.line_count);
+    CHECK_WITH(actual.document_count == expected.document_count, actual.document_count << " vs " << expected.document_count);
+    CHECK_WITH(actual.error_count == expected.error_count, actual.error_count << " vs " << expected.error_count);
+    CHECK(actual.errors.size() == min(expected.errors.size(), max_reported_errors));
+    for (size_t i = 0; i < min(actual.errors.size(), expected.errors.size()); ++i) {
+        CHECK_WITH(actual.errors[i].line_number == expected.errors[i].line_number && actual.errors[i].message == expected.errors[i].message,
+            actual.errors[i].line_number << ": " << actual.errors[i].message);
+    }
+}
+
+void CheckSameServer(mt19937& generator, const vector<string>& dictionary, SearchServer& actual, SearchServer& expected) {
+    CHECK(actual.GetDocumentCount() == expected.GetDocumentCount());
+    CHECK(vector<int>(actual.begin(), actual.end()) == vector<int>(expected.begin(), expected.end()));
+    for (const int document_id : expected) {
+        CHECK_WITH(actual.GetWordFrequencies(document_id) == expected.GetWordFrequencies(document_id), document_id);
+        CHECK_WITH(actual.GetDocumentText(document_id) == expected.GetDocumentText(document_id), document_id);
+    }
+    const auto any_document = [](int, DocumentStatus, int) {
+        return true;
+    };
+    for (int i = 0; i < 200; ++i) {
+        const string query = GenerateText(generator, dictionary, uniform_int_distribution(1, 4)(generator));
+        CHECK_WITH(AreSameDocuments(actual.FindTopDocuments(query, any_document), expected.FindTopDocuments(query, any_document)), query);
+        for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            CHECK_WITH(AreSameDocuments(actual.FindTopDocuments(query, static_cast<DocumentStatus>(status)),
+                expected.FindTopDocuments(query, static_cast<DocumentStatus>(status))), query);
+        }
+    }
+}
+
+// Chunks from one byte to bigger than the input, with a few errors reported or all of them
+void TestMatchesAddDocument() {
+    mt19937 generator(35);
+    const auto dictionary = GenerateDictionary(generator, 300, 5);
+    const string input = GenerateInput(generator, dictionary, 3000);
+    SearchServer expected(STOP_WORDS);
+    const LoadReport expected_report = LoadLineByLine(expected, input);
+    CHECK(expected_report.document_count > 0 && expected_report.error_count > 0);
+
+    for (const size_t chunk_size : { 1, 97, 4096, 1 << 20 }) {
+        for (const size_t max_reported_errors : { 3, 100000 }) {
+            DocumentLoaderOptions options;
+            options.chunk_size = chunk_size;
+            options.queue_capacity = 2;
+            options.max_reported_errors = max_reported_errors;
+            SearchServer actual(STOP_WORDS);
+            istringstream stream(input);
+            CheckSameReport(LoadDocuments(actual, stream, options), expected_report, max_reported_errors);
+            CheckSameServer(generator, dictionary, actual, expected);
+        }
+    }
+}
+
+// on_progress sees the report grow every progress_interval lines and gets the final one last
+void TestProgress() {
+    mt19937 generator(36);
+    const auto dictionary = GenerateDictionary(generator, 100, 4);
+    const string input = GenerateInput(generator, dictionary, 1000);
+
+    DocumentLoaderOptions options;
+    options.chunk_size = 256;
+    options.progress_interval = 100;
+    vector<LoadReport> progress;
+    options.on_progress = [&progress](const LoadReport& report) {
+        progress.push_back(report);
+    };
+    SearchServer search_server(STOP_WORDS);
+    istringstream stream(input);
+    const LoadReport report = LoadDocuments(search_server, stream, options);
+
+    CHECK(progress.size() >= report.line_count / options.progress_interval);
+    CHECK(progress.size() <= report.line_count / options.progress_interval + 1);
+    for (size_t i = 1; i < progress.size(); ++i) {
+        CHECK(progress[i].line_count >= progress[i - 1].line_count + (i + 1 < progress.size() ? options.progress_interval : 0));
+        CHECK(progress[i].document_count >= progress[i - 1].document_count);
+    }
+    if (!progress.empty()) {
+        CHECK(progress.back().line_count == report.line_count);
+        CHECK(progress.back().document_count == report.document_count);
+        CHECK(progress.back().error_count == report.error_count);
+    }
+}
+
+// "-" reads the standard input, any other path a file
+void TestFileAndStandardInput() {
+    mt19937 generator(37);
+    const auto dictionary = GenerateDictionary(generator, 100, 4);
+    const string input = GenerateInput(generator, dictionary, 500);
+    SearchServer expected(STOP_WORDS);
+    const LoadReport expected_report = LoadLineByLine(expected, input);
+
+    SearchServer from_stdin(STOP_WORDS);
+    istringstream stream(input);
+    streambuf* const stdin_buffer = cin.rdbuf(stream.rdbuf());
+    const LoadReport stdin_report = LoadDocumentsFromFile(from_stdin, "-"s);
+    cin.rdbuf(stdin_buffer);
+    CheckSameReport(stdin_report, expected_report, DocumentLoaderOptions{}.max_reported_errors);
+    CheckSameServer(generator, dictionary, from_stdin, expected);
+
+    const string path = (filesystem::temp_directory_path() / "document_loader_test.tsv").string();
+    {
+        ofstream file(path, ios::binary);
+        file << input;
+    }
+    SearchServer from_file(STOP_WORDS);
+    const LoadReport file_report = LoadDocumentsFromFile(from_file, path);
+    remove(path.c_str());
+    CheckSameReport(file_report, expected_report, DocumentLoaderOptions{}.max_reported_errors);
+    CheckSameServer(generator, dictionary, from_file, expected);
+
+    bool is_thrown = false;
+    try {
+        LoadDocumentsFromFile(from_file, path);
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    CHECK(is_thrown);
+}
+
+}  // namespace
+
+int main() {
+    TestMatchesAddDocument();
+    TestProgress();
+    TestFileAndStandardInput();
+    return ReportChecks("document_loader_test");
+}
@@ -0,0 +1,60 @@
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../document_store.h"
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+// Letters that CompressLz can't shorten, so a block is written past the stream buffer
+string GenerateIncompressibleText(mt19937& generator, size_t size) {
+    string text(size, ' ');
+    for (char& c : text) {
+        c = static_cast<char>(uniform_int_distribution<int>('a', 'z')(generator));
+    }
+    return text;
+}
+
+// A document whose text can't be written leaves nothing behind in the index.
+// Writes to /dev/full fail, so this check needs Linux.
+void TestFailedWriteLeavesIndexUnchanged() {
+    mt19937 generator(40);
+    SearchServer search_server(""s);
+    search_server.SetDocumentStore(make_shared<DocumentStore>("/dev/full"s, DocumentStoreOptions{ 1, 1 }));
+    search_server.AddDocument(1, "first "s + GenerateIncompressibleText(generator, 100000), DocumentStatus::ACTUAL, { 1 });
+
+    bool is_thrown = false;
+    try {
+        // The block of the first document is written when the second one does not fit in it
+        search_server.AddDocument(2, "second"s, DocumentStatus::ACTUAL, { 2 });
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    CHECK(is_thrown);
+    CHECK(search_server.GetDocumentCount() == 1);
+    CHECK(search_server.GetWordFrequencies(2).empty());
+    for (const string& query : { "second"s, "+second"s, "sec*"s, "+first second"s }) {
+        try {
+            CHECK_WITH(search_server.FindTopDocuments(query).empty() == (query != "+first second"s), query);
+        }
+        catch (const exception& e) {
+            CHECK_WITH(false, query << ": " << e.what());
+        }
+    }
+    CHECK(search_server.FindTopDocuments("first"s).size() == 1);
+    CHECK(search_server.GetDocumentText(1).substr(0, 6) == "first "s);
+}
+
+}  // namespace
+
+int main() {
+    TestFailedWriteLeavesIndexUnchanged();
+    return ReportChecks("document_store_test");
+}
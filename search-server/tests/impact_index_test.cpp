@@ -0,0 +1,86 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../impact_index.h"
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+// Plus and minus words only, the queries ImpactIndex scores itself
+string GeneratePlainQuery(mt19937& generator, const vector<string>& dictionary, int word_count) {
+    string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_int_distribution(0, 4)(generator) == 0) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+void CheckQueries(mt19937& generator, const vector<string>& dictionary, const SearchServer& search_server,
+    const ImpactIndex& impact_index) {
+    for (int i = 0; i < 300; ++i) {
+        const string query = GeneratePlainQuery(generator, dictionary, uniform_int_distribution(1, 6)(generator));
+        for (int status = 0; status < DOCUMENT_STATUS_COUNT; ++status) {
+            const auto document_status = static_cast<DocumentStatus>(status);
+            CHECK_WITH(AreSameDocuments(impact_index.FindTopDocuments(query, document_status),
+                search_server.FindTopDocuments(query, document_status)), query);
+        }
+    }
+}
+
+// Adding or removing documents after the index is built must not bring back removed
+// documents or mix the IDF of the build with that of the server
+void TestServerChangesAfterBuild(ImpactPrecision precision) {
+    mt19937 generator(31);
+    const auto dictionary = GenerateDictionary(generator, 300, 3);
+    SearchServer search_server(vector<string>{ dictionary[0] });
+    for (int document_id = 0; document_id < 2000; ++document_id) {
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        search_server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)),
+            status, { uniform_int_distribution(-5, 5)(generator) });
+    }
+
+    const ImpactIndex impact_index(search_server, precision);
+    CHECK(impact_index.IsUpToDate());
+    CheckQueries(generator, dictionary, search_server, impact_index);
+
+    for (int document_id = 0; document_id < 2000; document_id += 2) {
+        search_server.RemoveDocument(document_id);
+    }
+    CHECK(!impact_index.IsUpToDate());
+    CheckQueries(generator, dictionary, search_server, impact_index);
+    for (int document_id = 0; document_id < 2000; ++document_id) {
+        const string query = dictionary[uniform_int_distribution<size_t>(1, dictionary.size() - 1)(generator)];
+        for (const Document& document : impact_index.FindTopDocuments(query)) {
+            CHECK_WITH(document.id % 2 == 1, query);
+        }
+    }
+
+    for (int document_id = 5000; document_id < 5200; ++document_id) {
+        search_server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)),
+            DocumentStatus::ACTUAL, { 1 });
+    }
+    CheckQueries(generator, dictionary, search_server, impact_index);
+
+    const ImpactIndex rebuilt_index(search_server, precision);
+    CHECK(rebuilt_index.IsUpToDate());
+    CheckQueries(generator, dictionary, search_server, rebuilt_index);
+}
+
+}  // namespace
+
+int main() {
+    for (const ImpactPrecision precision : { ImpactPrecision::FLOAT32, ImpactPrecision::UINT16, ImpactPrecision::UINT8 }) {
+        TestServerChangesAfterBuild(precision);
+    }
+    return ReportChecks("impact_index_test");
+}
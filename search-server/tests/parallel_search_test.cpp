@@ -0,0 +1,97 @@
+#include <execution>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+SearchServer MakeServer(mt19937& generator, const vector<string>& dictionary) {
+    SearchServer search_server(vector<string>{ dictionary[0], dictionary[1] });
+    for (int document_id = 0; document_id < 3000; ++document_id) {
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        search_server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 30)(generator)),
+            status, { uniform_int_distribution(-5, 5)(generator) });
+    }
+    // Removed documents leave free slots and words without documents behind
+    for (int document_id = 0; document_id < 3000; document_id += 3) {
+        search_server.RemoveDocument(document_id);
+    }
+    return search_server;
+}
+
+void TestFindTopDocuments() {
+    mt19937 generator(33);
+    const auto dictionary = GenerateDictionary(generator, 500, 4);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+
+    for (int i = 0; i < 1000; ++i) {
+        const string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 10)(generator));
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        const QueryMode mode = i % 4 == 0 ? QueryMode::ALL : QueryMode::ANY;
+        CHECK_WITH(AreCloseDocuments(search_server.FindTopDocuments(execution::seq, query, status, mode),
+            search_server.FindTopDocuments(execution::par, query, status, mode)), query);
+
+        const auto predicate = [](int document_id, DocumentStatus, int rating) {
+            return document_id % 2 == 0 && rating >= 0;
+        };
+        CHECK_WITH(AreCloseDocuments(search_server.FindTopDocuments(execution::seq, query, predicate, mode),
+            search_server.FindTopDocuments(execution::par, query, predicate, mode)), query);
+        CHECK_WITH(AreCloseDocuments(search_server.FindTopDocuments(execution::seq, query, RatingRange{ -2, 2 }, mode),
+            search_server.FindTopDocuments(execution::par, query, RatingRange{ -2, 2 }, mode)), query);
+    }
+}
+
+void TestMatchDocument() {
+    mt19937 generator(34);
+    const auto dictionary = GenerateDictionary(generator, 500, 4);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+
+    for (int i = 0; i < 3000; ++i) {
+        const string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 10)(generator));
+        int document_id = uniform_int_distribution(0, 2999)(generator);
+        if (document_id % 3 == 0) {
+            ++document_id;
+        }
+        const auto [seq_words, seq_status] = search_server.MatchDocument(execution::seq, query, document_id);
+        const auto [par_words, par_status] = search_server.MatchDocument(execution::par, query, document_id);
+        CHECK_WITH(seq_words == par_words && seq_status == par_status, query << " in " << document_id);
+    }
+}
+
+// The queries with prefixes or required words run on their own, the others in shared groups
+void TestFindTopDocumentsBatch() {
+    mt19937 generator(35);
+    const auto dictionary = GenerateDictionary(generator, 500, 4);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+
+    vector<string> queries;
+    vector<vector<Document>> expected;
+    while (queries.size() < 1000) {
+        string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 10)(generator));
+        try {
+            expected.push_back(search_server.FindTopDocuments(query));
+            queries.push_back(move(query));
+        }
+        catch (const invalid_argument&) {
+        }
+    }
+    const auto results = search_server.FindTopDocumentsBatch(queries);
+    CHECK(results.size() == queries.size());
+    for (size_t i = 0; i < min(results.size(), queries.size()); ++i) {
+        CHECK_WITH(AreSameDocuments(results[i], expected[i]), queries[i]);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestFindTopDocuments();
+    TestMatchDocument();
+    TestFindTopDocumentsBatch();
+    return ReportChecks("parallel_search_test");
+}
@@ -0,0 +1,82 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+// Counts the heap allocations of the program
+atomic<size_t> allocation_count = 0;
+
+void* operator new(size_t size) {
+    ++allocation_count;
+    if (void* pointer = malloc(size > 0 ? size : 1)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+namespace {
+
+// Plus words with minus words in about one query of two
+string GeneratePlainQuery(mt19937& generator, const vector<string>& dictionary) {
+    string query;
+    const int word_count = uniform_int_distribution(1, 10)(generator);
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (uniform_int_distribution(0, 9)(generator) == 0) {
+            query.push_back('-');
+        }
+        query += dictionary[uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+// Once a QueryContext has grown, queries of plus and minus words allocate nothing
+void TestWarmContextDoesNotAllocate() {
+    mt19937 generator(41);
+    const auto dictionary = GenerateDictionary(generator, 500, 5);
+    SearchServer search_server(vector<string>{ dictionary[0] });
+    for (int document_id = 0; document_id < 5000; ++document_id) {
+        search_server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 40)(generator)),
+            DocumentStatus::ACTUAL, { document_id % 7 });
+    }
+    vector<string> queries;
+    for (int i = 0; i < 500; ++i) {
+        queries.push_back(GeneratePlainQuery(generator, dictionary));
+    }
+
+    SearchServer::QueryContext context;
+    for (const string& query : queries) {
+        search_server.FindTopDocuments(context, query);
+    }
+    for (const string& query : queries) {
+        const size_t allocations_before = allocation_count;
+        search_server.FindTopDocuments(context, query);
+        search_server.FindTopDocuments(context, query, DocumentStatus::BANNED);
+        const size_t allocations = allocation_count - allocations_before;
+        CHECK_WITH(allocations == 0, query << ": " << allocations << " allocations");
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestWarmContextDoesNotAllocate();
+    return ReportChecks("query_allocations_test");
+}
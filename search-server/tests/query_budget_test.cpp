@@ -0,0 +1,81 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../process_queries.h"
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+SearchServer MakeServer(mt19937& generator, const vector<string>& dictionary) {
+    SearchServer search_server(""s);
+    for (int document_id = 0; document_id < 5000; ++document_id) {
+        search_server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)),
+            DocumentStatus::ACTUAL, { document_id % 11 });
+    }
+    return search_server;
+}
+
+// A single prefix expanding to thousands of postings used to be merged in full
+void TestBudgetCutsPrefixMerge() {
+    mt19937 generator(42);
+    const auto dictionary = GenerateDictionary(generator, 300, 4);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+
+    QueryBudget budget;
+    budget.max_postings = 100;
+    for (const string& query : { "a*"s, "b*"s, "-c* a*"s }) {
+        const SearchResult result = search_server.FindTopDocuments(query, budget);
+        CHECK_WITH(result.is_approximate, query);
+
+        const SearchResult unlimited = search_server.FindTopDocuments(query, QueryBudget{});
+        CHECK_WITH(!unlimited.is_approximate, query);
+        CHECK_WITH(AreSameDocuments(unlimited.documents, search_server.FindTopDocuments(query)), query);
+    }
+
+    // A budget larger than the query changes nothing
+    budget.max_postings = 1 << 30;
+    const SearchResult result = search_server.FindTopDocuments("a* b*"s, budget);
+    CHECK(!result.is_approximate);
+    CHECK(AreSameDocuments(result.documents, search_server.FindTopDocuments("a* b*"s)));
+}
+
+void TestProcessQueriesWithBudget() {
+    mt19937 generator(43);
+    const auto dictionary = GenerateDictionary(generator, 300, 4);
+    const SearchServer search_server = MakeServer(generator, dictionary);
+
+    vector<string> queries;
+    while (queries.size() < 300) {
+        string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 6)(generator));
+        try {
+            search_server.FindTopDocuments(query);
+            queries.push_back(move(query));
+        }
+        catch (const invalid_argument&) {
+        }
+    }
+    QueryBudget budget;
+    budget.max_postings = 500;
+    const vector<SearchResult> results = ProcessQueries(search_server, queries, budget);
+    CHECK(results.size() == queries.size());
+    int approximate_count = 0;
+    for (size_t i = 0; i < min(results.size(), queries.size()); ++i) {
+        const SearchResult expected = search_server.FindTopDocuments(queries[i], budget);
+        CHECK_WITH(results[i].is_approximate == expected.is_approximate, queries[i]);
+        CHECK_WITH(AreSameDocuments(results[i].documents, expected.documents), queries[i]);
+        approximate_count += results[i].is_approximate;
+    }
+    CHECK(approximate_count > 0);
+}
+
+}  // namespace
+
+int main() {
+    TestBudgetCutsPrefixMerge();
+    TestProcessQueriesWithBudget();
+    return ReportChecks("query_budget_test");
+}
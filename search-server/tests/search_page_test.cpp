@@ -0,0 +1,75 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+const size_t ALL_DOCUMENTS = 1 << 20;
+
+// Pages of every size put together give the whole ranking, and its head is FindTopDocuments
+void CheckPages(mt19937& generator, const vector<string>& dictionary, const SearchServer& server, int query_count) {
+    for (int i = 0; i < query_count; ++i) {
+        const string query = i % 2 == 0
+            ? GenerateQuery(generator, dictionary, uniform_int_distribution(1, 8)(generator))
+            : GenerateText(generator, dictionary, uniform_int_distribution(1, 8)(generator));
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        const QueryMode mode = i % 5 == 0 ? QueryMode::ALL : QueryMode::ANY;
+        vector<Document> ranking;
+        try {
+            ranking = server.FindFirstPage(query, ALL_DOCUMENTS, status, mode).documents;
+        }
+        catch (const invalid_argument&) {
+            continue;
+        }
+        const vector<Document> top(ranking.begin(), ranking.begin() + min<size_t>(ranking.size(), MAX_RESULT_DOCUMENT_COUNT));
+        CHECK_WITH(AreSameDocuments(server.FindTopDocuments(query, status, mode), top), query);
+
+        for (const size_t page_size : { 1, 2, 5, 17 }) {
+            vector<Document> documents;
+            SearchPage page = server.FindFirstPage(query, page_size, status, mode);
+            while (true) {
+                CHECK_WITH(page.documents.size() <= page_size, query);
+                documents.insert(documents.end(), page.documents.begin(), page.documents.end());
+                if (page.next.IsEnd() || documents.size() > ranking.size()) {
+                    break;
+                }
+                CHECK_WITH(page.documents.size() == page_size, query);
+                page = server.FetchNextPage(page.next, page_size);
+            }
+            CHECK_WITH(AreSameDocuments(documents, ranking), query << ", page size " << page_size);
+        }
+    }
+}
+
+void TestPagesMatchRanking() {
+    mt19937 generator(37);
+    const auto dictionary = GenerateDictionary(generator, 300, 4);
+    SearchServer server(vector<string>{ dictionary[0] });
+    vector<int> document_ids;
+    for (int document_id = 0; document_id < 3000; ++document_id) {
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        server.AddDocument(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 30)(generator)),
+            status, { uniform_int_distribution(-5, 5)(generator) });
+        document_ids.push_back(document_id);
+    }
+    CheckPages(generator, dictionary, server, 300);
+
+    // The bounds of the words are not lowered by removals
+    shuffle(document_ids.begin(), document_ids.end(), generator);
+    for (size_t i = 0; i < 2000; ++i) {
+        server.RemoveDocument(document_ids[i]);
+    }
+    CheckPages(generator, dictionary, server, 300);
+}
+
+}  // namespace
+
+int main() {
+    TestPagesMatchRanking();
+    return ReportChecks("search_page_test");
+}
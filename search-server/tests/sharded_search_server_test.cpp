@@ -0,0 +1,133 @@
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../sharded_search_server.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+// Removing the last document of a word left an empty posting list in its shard,
+// while the word was gone from the corpus statistics
+void TestRemoveLastDocumentOfWord() {
+    SearchServer single(""s);
+    ShardedSearchServer sharded(3, ""s);
+    single.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    sharded.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    single.AddDocument(2, "bird"s, DocumentStatus::ACTUAL, { 2 });
+    sharded.AddDocument(2, "bird"s, DocumentStatus::ACTUAL, { 2 });
+    single.RemoveDocument(1);
+    sharded.RemoveDocument(1);
+
+    for (const string& query : { "dog bird"s, "+bird dog"s, "bird -dog"s, "do* bird"s }) {
+        const auto expected = single.FindTopDocuments(query);
+        CHECK_WITH(expected.size() == 1, query);
+        CHECK_WITH(AreSameDocuments(sharded.FindTopDocuments(query), expected), query);
+    }
+}
+
+// A prefix expands to the same MAX_PREFIX_EXPANSIONS words on every shard as on a
+// single server, even when each shard has fewer matching words than that
+void TestPrefixAboveExpansionLimit() {
+    SearchServer single(""s);
+    ShardedSearchServer sharded(2, ""s);
+    for (int document_id = 0; document_id < 200; ++document_id) {
+        string word = to_string(document_id);
+        word = "pa"s + string(3 - word.size(), '0') + word;
+        const string text = word + (document_id % 3 == 0 ? " common"s : ""s);
+        single.AddDocument(document_id, text, DocumentStatus::ACTUAL, { document_id % 7 });
+        sharded.AddDocument(document_id, text, DocumentStatus::ACTUAL, { document_id % 7 });
+    }
+    CHECK(MAX_PREFIX_EXPANSIONS < 200);
+
+    for (const string& query : { "pa*"s, "pa1*"s, "common pa*"s, "+common pa*"s, "common -pa*"s, "pa0* -pa*"s }) {
+        for (const QueryMode mode : { QueryMode::ANY, QueryMode::ALL }) {
+            CHECK_WITH(AreSameDocuments(sharded.FindTopDocuments(query, mode), single.FindTopDocuments(query, mode)), query);
+        }
+    }
+    CHECK(!single.FindTopDocuments("pa*"s).empty());
+}
+
+// Random queries give bit-identical results on both, or fail on both
+void CheckQueries(mt19937& generator, const vector<string>& dictionary, const SearchServer& single,
+    const ShardedSearchServer& sharded, int query_count) {
+    for (int i = 0; i < query_count; ++i) {
+        const string query = GenerateQuery(generator, dictionary, uniform_int_distribution(1, 8)(generator));
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        const QueryMode mode = i % 4 == 0 ? QueryMode::ALL : QueryMode::ANY;
+        vector<Document> expected;
+        bool is_expected_error = false;
+        try {
+            expected = single.FindTopDocuments(query, status, mode);
+        }
+        catch (const invalid_argument&) {
+            is_expected_error = true;
+        }
+        try {
+            const auto actual = sharded.FindTopDocuments(query, status, mode);
+            CHECK_WITH(!is_expected_error && AreSameDocuments(actual, expected), query);
+        }
+        catch (const exception& e) {
+            CHECK_WITH(is_expected_error, query << ": " << e.what());
+        }
+    }
+}
+
+void TestMatchesSingleServer(size_t shard_count) {
+    mt19937 generator(static_cast<unsigned>(shard_count));
+    const auto dictionary = GenerateDictionary(generator, 400, 4);
+    const vector<string> stop_words = { dictionary[0], dictionary[1] };
+    SearchServer single(stop_words);
+    ShardedSearchServer sharded(shard_count, stop_words);
+
+    vector<int> document_ids;
+    const auto add_document = [&](int document_id, const string& text) {
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        const vector<int> ratings = { uniform_int_distribution(-10, 10)(generator), uniform_int_distribution(-10, 10)(generator) };
+        single.AddDocument(document_id, text, status, ratings);
+        sharded.AddDocument(document_id, text, status, ratings);
+        document_ids.push_back(document_id);
+    };
+    for (int document_id = 0; document_id < 2000; ++document_id) {
+        add_document(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)));
+    }
+    CheckQueries(generator, dictionary, single, sharded, 500);
+
+    // Most documents go away, so many words lose their last one
+    shuffle(document_ids.begin(), document_ids.end(), generator);
+    while (document_ids.size() > 300) {
+        single.RemoveDocument(document_ids.back());
+        sharded.RemoveDocument(document_ids.back());
+        document_ids.pop_back();
+    }
+    CHECK(sharded.GetDocumentCount() == single.GetDocumentCount());
+    CheckQueries(generator, dictionary, single, sharded, 500);
+
+    // New documents bring back some of the removed words, and attributes change in place
+    for (int document_id = 5000; document_id < 5500; ++document_id) {
+        add_document(document_id, GenerateText(generator, dictionary, uniform_int_distribution(1, 20)(generator)));
+    }
+    for (int i = 0; i < 200; ++i) {
+        const int document_id = document_ids[uniform_int_distribution<size_t>(0, document_ids.size() - 1)(generator)];
+        const auto status = static_cast<DocumentStatus>(uniform_int_distribution(0, DOCUMENT_STATUS_COUNT - 1)(generator));
+        single.SetDocumentStatus(document_id, status);
+        sharded.SetDocumentStatus(document_id, status);
+        single.SetDocumentRating(document_id, { i });
+        sharded.SetDocumentRating(document_id, { i });
+    }
+    CheckQueries(generator, dictionary, single, sharded, 500);
+}
+
+}  // namespace
+
+int main() {
+    TestRemoveLastDocumentOfWord();
+    TestPrefixAboveExpansionLimit();
+    for (const size_t shard_count : { 1, 2, 3, 7 }) {
+        TestMatchesSingleServer(shard_count);
+    }
+    return ReportChecks("sharded_search_server_test");
+}
@@ -0,0 +1,76 @@
+#include <array>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../stop_word_set.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+const size_t COMPILE_TIME_WORD_COUNT = 2000;
+
+// Distinct three-letter words "aaa", "aab", ... one after another
+constexpr array<char, 3 * COMPILE_TIME_WORD_COUNT> MakeLetters() {
+    array<char, 3 * COMPILE_TIME_WORD_COUNT> letters{};
+    for (size_t i = 0; i < COMPILE_TIME_WORD_COUNT; ++i) {
+        letters[3 * i] = static_cast<char>('a' + i / 676);
+        letters[3 * i + 1] = static_cast<char>('a' + i / 26 % 26);
+        letters[3 * i + 2] = static_cast<char>('a' + i % 26);
+    }
+    return letters;
+}
+
+constexpr auto LETTERS = MakeLetters();
+
+// Every word is given twice, and the last ones are empty
+constexpr array<string_view, 2 * COMPILE_TIME_WORD_COUNT + 2> MakeWords() {
+    array<string_view, 2 * COMPILE_TIME_WORD_COUNT + 2> words{};
+    for (size_t i = 0; i < COMPILE_TIME_WORD_COUNT; ++i) {
+        words[i] = string_view(LETTERS.data() + 3 * i, 3);
+        words[COMPILE_TIME_WORD_COUNT + i] = words[i];
+    }
+    return words;
+}
+
+// Used to exceed the operation limit of the compiler at 200 words
+constexpr auto STOP_WORDS = MakeStopWordTable(MakeWords());
+
+void TestCompileTimeTable() {
+    CHECK(STOP_WORDS.word_count == COMPILE_TIME_WORD_COUNT);
+    const StopWordSet stop_words(STOP_WORDS);
+    for (size_t i = 0; i < COMPILE_TIME_WORD_COUNT; ++i) {
+        const string_view word(LETTERS.data() + 3 * i, 3);
+        CHECK_WITH(stop_words.Contains(word), word);
+        CHECK_WITH(!stop_words.Contains(string(word) + 'a'), word);
+    }
+    CHECK(!stop_words.Contains("zzz"sv));
+    CHECK(!stop_words.Contains(""sv));
+}
+
+void TestRunTimeSet(size_t word_count) {
+    mt19937 generator(static_cast<unsigned>(word_count));
+    auto words = GenerateDictionary(generator, static_cast<int>(word_count), 12);
+    const vector<string> others(words.begin() + words.size() / 2, words.end());
+    words.resize(words.size() / 2);
+    const StopWordSet stop_words(words);
+    for (const string& word : words) {
+        CHECK_WITH(stop_words.Contains(word), word);
+    }
+    for (const string& word : others) {
+        CHECK_WITH(!stop_words.Contains(word), word);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestCompileTimeTable();
+    for (const size_t word_count : { 10, 1000, 200000 }) {
+        TestRunTimeSet(word_count);
+    }
+    return ReportChecks("stop_word_set_test");
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../document.h"
+
+// Every check in this directory is a program of its own: it prints the failed
+// conditions and exits with 1 if there were any, see ReportChecks.
+
+inline int check_failure_count = 0;
+
+#define CHECK(condition)                                                                   \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            ++check_failure_count;                                                         \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #condition << std::endl; \
+        }                                                                                  \
+    } while (false)
+
+// Same as CHECK, printing context (anything with operator<<) when it fails
+#define CHECK_WITH(condition, context)                                                     \
+    do {                                                                                   \
+        if (!(condition)) {                                                                \
+            ++check_failure_count;                                                         \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #condition      \
+                << " (" << context << ')' << std::endl;                                    \
+        }                                                                                  \
+    } while (false)
+
+inline int ReportChecks(std::string_view name) {
+    if (check_failure_count == 0) {
+        std::cout << name << ": OK" << std::endl;
+        return 0;
+    }
+    std::cout << name << ": " << check_failure_count << " failed checks" << std::endl;
+    return 1;
+}
+
+// Results are compared bit for bit, relevance included
+inline bool AreSameDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& left, const Document& right) {
+        return left.id == right.id && left.relevance == right.relevance && left.rating == right.rating;
+        });
+}
+
+// The parallel search adds the words of a document up in any order, so its
+// relevance may differ from the sequential one in the last bits
+inline bool AreCloseDocuments(const std::vector<Document>& lhs, const std::vector<Document>& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& left, const Document& right) {
+        return left.id == right.id && std::abs(left.relevance - right.relevance) < 1e-12 && left.rating == right.rating;
+        });
+}
+
+// Short words of a small alphabet, so that they repeat and share prefixes
+inline std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length) {
+    std::vector<std::string> words;
+    for (int i = 0; i < word_count; ++i) {
+        std::string word(std::uniform_int_distribution(1, max_length)(generator), ' ');
+        for (char& c : word) {
+            c = static_cast<char>(std::uniform_int_distribution<int>('a', 'h')(generator));
+        }
+        words.push_back(std::move(word));
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+inline std::string GenerateText(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count) {
+    std::string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+    }
+    return text;
+}
+
+// Query mixing plus words with minus words, required words and prefixes
+inline std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count) {
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        const std::string& word = dictionary[std::uniform_int_distribution<size_t>(0, dictionary.size() - 1)(generator)];
+        switch (std::uniform_int_distribution(0, 9)(generator)) {
+        case 0:
+            query += '-' + word;
+            break;
+        case 1:
+            query += '+' + word;
+            break;
+        case 2:
+            query += word.substr(0, 2) + '*';
+            break;
+        case 3:
+            query += '-' + word.substr(0, 2) + '*';
+            break;
+        default:
+            query += word;
+        }
+    }
+    return query;
+}
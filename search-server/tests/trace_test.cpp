@@ -0,0 +1,333 @@
+#include <cctype>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../search_server.h"
+#include "../trace.h"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace {
+
+// Just enough of JSON to read the trace back; malformed text throws invalid_argument
+struct JsonValue {
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = Type::NUL;
+    double number = 0.0;
+    string text;
+    vector<JsonValue> items;
+    map<string, JsonValue> fields;
+
+    const JsonValue& operator[](const string& key) const {
+        const auto it = fields.find(key);
+        if (type != Type::OBJECT || it == fields.end()) {
+            throw invalid_argument("No field "s + key);
+        }
+        return it->second;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(string_view text)
+        : text_(text) {
+    }
+
+    JsonValue ParseDocument() {
+        JsonValue value = ParseValue();
+        SkipSpaces();
+        if (pos_ != text_.size()) {
+            throw invalid_argument("Text after the value"s);
+        }
+        return value;
+    }
+
+private:
+    char Peek() {
+        SkipSpaces();
+        if (pos_ == text_.size()) {
+            throw invalid_argument("Unexpected end"s);
+        }
+        return text_[pos_];
+    }
+
+    void Expect(char c) {
+        if (Peek() != c) {
+            throw invalid_argument("Expected "s + c + " at "s + to_string(pos_));
+        }
+        ++pos_;
+    }
+
+    void SkipSpaces() {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\n' || text_[pos_] == '\r' || text_[pos_] == '\t')) {
+            ++pos_;
+        }
+    }
+
+    JsonValue ParseValue() {
+        JsonValue value;
+        const char c = Peek();
+        if (c == '{') {
+            value.type = JsonValue::Type::OBJECT;
+            ++pos_;
+            if (Peek() == '}') {
+                ++pos_;
+                return value;
+            }
+            while (true) {
+                string key = ParseString();
+                Expect(':');
+                if (!value.fields.emplace(move(key), ParseValue()).second) {
+                    throw invalid_argument("Repeated key"s);
+                }
+                if (Peek() == '}') {
+                    ++pos_;
+                    return value;
+                }
+                Expect(',');
+            }
+        }
+        if (c == '[') {
+            value.type = JsonValue::Type::ARRAY;
+            ++pos_;
+            if (Peek() == ']') {
+                ++pos_;
+                return value;
+            }
+            while (true) {
+                value.items.push_back(ParseValue());
+                if (Peek() == ']') {
+                    ++pos_;
+                    return value;
+                }
+                Expect(',');
+            }
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            value.text = ParseString();
+            return value;
+        }
+        for (const auto& [word, type] : { pair{ "true"sv, JsonValue::Type::BOOL }, pair{ "false"sv, JsonValue::Type::BOOL },
+            pair{ "null"sv, JsonValue::Type::NUL } }) {
+            if (text_.substr(pos_, word.size()) == word) {
+                pos_ += word.size();
+                value.type = type;
+                value.number = word == "true"sv;
+                return value;
+            }
+        }
+        value.type = JsonValue::Type::NUMBER;
+        value.number = ParseNumber();
+        return value;
+    }
+
+    double ParseNumber() {
+        const size_t begin = pos_;
+        if (pos_ < text_.size() && text_[pos_] == '-') {
+            ++pos_;
+        }
+        const size_t digits = pos_;
+        while (pos_ < text_.size() && isdigit(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+        if (pos_ == digits || (text_[digits] == '0' && pos_ - digits > 1)) {
+            throw invalid_argument("Invalid number at "s + to_string(begin));
+        }
+        if (pos_ < text_.size() && text_[pos_] == '.') {
+            const size_t fraction = ++pos_;
+            while (pos_ < text_.size() && isdigit(static_cast<unsigned char>(text_[pos_]))) {
+                ++pos_;
+            }
+            if (pos_ == fraction) {
+                throw invalid_argument("Invalid number at "s + to_string(begin));
+            }
+        }
+        return stod(string(text_.substr(begin, pos_ - begin)));
+    }
+
+    string ParseString() {
+        Expect('"');
+        string result;
+        while (true) {
+            if (pos_ == text_.size()) {
+                throw invalid_argument("Unterminated string"s);
+            }
+            const char c = text_[pos_++];
+            if (c == '"') {
+                return result;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                throw invalid_argument("Control character in string"s);
+            }
+            if (c != '\\') {
+                result.push_back(c);
+                continue;
+            }
+            if (pos_ == text_.size()) {
+                throw invalid_argument("Unterminated string"s);
+            }
+            const char escaped = text_[pos_++];
+            const string_view simple = "\"\\/bfnrt"sv;
+            const string_view replaced = "\"\\/\b\f\n\r\t"sv;
+            if (const size_t index = simple.find(escaped); index != simple.npos) {
+                result.push_back(replaced[index]);
+            }
+            else if (escaped == 'u' && pos_ + 4 <= text_.size()) {
+                const int code = stoi(string(text_.substr(pos_, 4)), nullptr, 16);
+                pos_ += 4;
+                if (code >= 0x80) {
+                    throw invalid_argument("Only ASCII escapes are expected"s);
+                }
+                result.push_back(static_cast<char>(code));
+            }
+            else {
+                throw invalid_argument("Invalid escape"s);
+            }
+        }
+    }
+
+    string_view text_;
+    size_t pos_ = 0;
+};
+
+JsonValue FlushAndParse() {
+    ostringstream out;
+    Tracer::Instance().Flush(out);
+    try {
+        return JsonParser(out.str()).ParseDocument();
+    }
+    catch (const exception& e) {
+        CHECK_WITH(false, "invalid trace JSON: " << e.what());
+        return {};
+    }
+}
+
+// Complete ("X") events of the trace by name
+vector<JsonValue> GetEvents(const JsonValue& trace, string_view name) {
+    vector<JsonValue> events;
+    if (trace.type != JsonValue::Type::OBJECT) {
+        return events;
+    }
+    for (const JsonValue& event : trace["traceEvents"s].items) {
+        if (event["ph"s].text == "X"s && event["name"s].text == name) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+// Every thread overflows its ring buffer: the trace keeps the last events of each
+// thread in order, and names and arguments come back as they were written
+void TestThreadsAndWraparound() {
+    const size_t capacity = 50;
+    const int thread_count = 4;
+    const int span_count = 120;
+    const string tricky = "quote\" backslash\\ newline\n tab\t bell\x07 utf-8 \xd0\xba\xd0\xbe\xd1\x82"s;
+
+    Tracer::Instance().Enable(capacity);
+    vector<thread> threads;
+    for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
+        threads.emplace_back([thread_index, &tricky] {
+            for (int index = 0; index < span_count; ++index) {
+                TraceSpan span("span "s + tricky);
+                span.AddArg("thread"sv, thread_index);
+                span.AddArg("index"sv, index);
+                span.AddArg("share"sv, index / 4.0);
+                span.AddArg("text"sv, tricky);
+            }
+        });
+    }
+    for (thread& t : threads) {
+        t.join();
+    }
+    Tracer::Instance().Disable();
+    {
+        TraceSpan span("disabled"sv);
+        CHECK(!span.IsActive());
+    }
+
+    const JsonValue trace = FlushAndParse();
+    if (trace.type != JsonValue::Type::OBJECT) {
+        return;
+    }
+    map<int, vector<int>> indexes_by_thread;
+    map<int, int> tid_by_thread;
+    for (const JsonValue& event : GetEvents(trace, "span "s + tricky)) {
+        const JsonValue& args = event["args"s];
+        const int thread_index = static_cast<int>(args["thread"s].number);
+        indexes_by_thread[thread_index].push_back(static_cast<int>(args["index"s].number));
+        CHECK(args["text"s].text == tricky);
+        CHECK(args["share"s].number == args["index"s].number / 4.0);
+        CHECK(event["dur"s].number >= 0 && event["ts"s].number >= 0);
+        const int tid = static_cast<int>(event["tid"s].number);
+        CHECK(tid_by_thread.emplace(thread_index, tid).first->second == tid);
+    }
+    CHECK(GetEvents(trace, "disabled"sv).empty());
+    CHECK(indexes_by_thread.size() == thread_count);
+    for (const auto& [thread_index, indexes] : indexes_by_thread) {
+        vector<int> expected;
+        for (int index = span_count - static_cast<int>(capacity); index < span_count; ++index) {
+            expected.push_back(index);
+        }
+        CHECK_WITH(indexes == expected, "thread " << thread_index);
+    }
+    map<int, int> thread_names;
+    for (const JsonValue& event : trace["traceEvents"s].items) {
+        if (event["ph"s].text == "M"s) {
+            ++thread_names[static_cast<int>(event["tid"s].number)];
+        }
+    }
+    for (const auto& [thread_index, tid] : tid_by_thread) {
+        CHECK_WITH(thread_names[tid] == 1, "tid " << tid);
+    }
+
+    // Flush empties the buffers
+    CHECK(GetEvents(FlushAndParse(), "span "s + tricky).empty());
+}
+
+// A page fetch records itself and how its candidates were found
+void TestPagingSpans() {
+    SearchServer search_server("and"s);
+    for (int document_id = 0; document_id < 100; ++document_id) {
+        search_server.AddDocument(document_id, document_id % 3 == 0 ? "white cat and dog"s : "black dog"s,
+            DocumentStatus::ACTUAL, { document_id % 5 });
+    }
+
+    Tracer::Instance().Enable();
+    const SearchPage first_page = search_server.FindFirstPage("cat dog"s, 10);
+    search_server.FetchNextPage(first_page.next, 10);
+    search_server.FindFirstPage("+cat dog"s, 10);
+    Tracer::Instance().Disable();
+
+    const JsonValue trace = FlushAndParse();
+    CHECK(GetEvents(trace, "FindFirstPage"sv).size() == 2);
+    const auto fetches = GetEvents(trace, "FetchNextPage"sv);
+    CHECK(fetches.size() == 3);
+    for (const JsonValue& fetch : fetches) {
+        CHECK(fetch["args"s]["page_size"s].number == 10);
+        CHECK(fetch["args"s]["documents"s].number == 10);
+    }
+    const auto candidates = GetEvents(trace, "FindPageCandidates"sv);
+    CHECK(candidates.size() == 3);
+    if (candidates.size() == 3) {
+        CHECK(candidates[0]["args"s]["pruning"s].text == "max_score"s);
+        CHECK(candidates[0]["args"s]["visited"s].number >= candidates[0]["args"s]["scored"s].number);
+        CHECK(candidates[2]["args"s]["pruning"s].text == "none"s);
+    }
+}
+
+}  // namespace
+
+int main() {
+    TestThreadsAndWraparound();
+    TestPagingSpans();
+    return ReportChecks("trace_test");
+}
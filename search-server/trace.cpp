@@ -0,0 +1,182 @@
+#include "trace.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+Tracer& Tracer::Instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::Enable(size_t events_per_thread) {
+    capacity_.store(events_per_thread > 0 ? events_per_thread : 1, memory_order_relaxed);
+    enabled_.store(true, memory_order_release);
+}
+
+void Tracer::Disable() {
+    enabled_.store(false, memory_order_release);
+}
+
+int64_t Tracer::NowMicroseconds() const {
+    return chrono::duration_cast<chrono::microseconds>(Clock::now() - epoch_).count();
+}
+
+Tracer::ThreadBuffer& Tracer::GetThreadBuffer() {
+    // Буфер принадлежит трассировщику, поэтому события потока
+    // переживают завершение самого потока.
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        auto created = make_shared<ThreadBuffer>();
+        lock_guard guard(buffers_mutex_);
+        created->thread_id = static_cast<int>(buffers_.size()) + 1;
+        buffers_.push_back(created);
+        buffer = created.get();
+    }
+    return *buffer;
+}
+
+void Tracer::Record(Event event) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    event.thread_id = buffer.thread_id;
+
+    lock_guard guard(buffer.mutex);
+    const size_t capacity = capacity_.load(memory_order_relaxed);
+    if (buffer.events.size() != capacity) {
+        buffer.events.clear();
+        buffer.events.resize(capacity);
+        buffer.head = 0;
+        buffer.size = 0;
+    }
+    buffer.events[(buffer.head + buffer.size) % capacity] = move(event);
+    if (buffer.size < capacity) {
+        ++buffer.size;
+    }
+    else {
+        buffer.head = (buffer.head + 1) % capacity;
+    }
+}
+
+void Tracer::Flush(ostream& out) {
+    vector<shared_ptr<ThreadBuffer>> buffers;
+    {
+        lock_guard guard(buffers_mutex_);
+        buffers = buffers_;
+    }
+
+    out << "{\"traceEvents\":["s;
+    bool first = true;
+    for (const auto& buffer : buffers) {
+        lock_guard guard(buffer->mutex);
+        if (!first) {
+            out << ',';
+        }
+        first = false;
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"s << buffer->thread_id
+            << ",\"args\":{\"name\":\"thread "s << buffer->thread_id << "\"}}"s;
+
+        for (size_t i = 0; i < buffer->size; ++i) {
+            const Event& event = buffer->events[(buffer->head + i) % buffer->events.size()];
+            string name;
+            AppendJsonEscaped(name, event.name);
+            out << ",{\"name\":\""s << name
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"s << event.thread_id
+                << ",\"ts\":"s << event.start_us
+                << ",\"dur\":"s << event.duration_us
+                << ",\"args\":{"s << event.args << "}}"s;
+        }
+        buffer->head = 0;
+        buffer->size = 0;
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}"s << endl;
+}
+
+bool Tracer::FlushToFile(const string& path) {
+    ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    Flush(out);
+    return static_cast<bool>(out);
+}
+
+TraceSpan::TraceSpan(string_view name)
+    : active_(Tracer::Instance().IsEnabled()) {
+    if (active_) {
+        event_.name = string(name);
+        event_.start_us = Tracer::Instance().NowMicroseconds();
+    }
+}
+
+TraceSpan::~TraceSpan() {
+    if (!active_) {
+        return;
+    }
+    Tracer& tracer = Tracer::Instance();
+    event_.duration_us = tracer.NowMicroseconds() - event_.start_us;
+    tracer.Record(move(event_));
+}
+
+void TraceSpan::AppendKey(string_view key) {
+    if (!event_.args.empty()) {
+        event_.args.push_back(',');
+    }
+    event_.args.push_back('"');
+    AppendJsonEscaped(event_.args, key);
+    event_.args += "\":"s;
+}
+
+void TraceSpan::AddArg(string_view key, string_view value) {
+    if (!active_) {
+        return;
+    }
+    AppendKey(key);
+    event_.args.push_back('"');
+    AppendJsonEscaped(event_.args, value);
+    event_.args.push_back('"');
+}
+
+void TraceSpan::AddNumber(string_view key, int64_t value) {
+    if (!active_) {
+        return;
+    }
+    AppendKey(key);
+    event_.args += to_string(value);
+}
+
+void TraceSpan::AddNumber(string_view key, double value) {
+    if (!active_) {
+        return;
+    }
+    AppendKey(key);
+    event_.args += to_string(value);
+}
+
+void AppendJsonEscaped(string& out, string_view text) {
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            out += "\\\""s;
+            break;
+        case '\\':
+            out += "\\\\"s;
+            break;
+        case '\n':
+            out += "\\n"s;
+            break;
+        case '\t':
+            out += "\\t"s;
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                out += escaped;
+            }
+            else {
+                out.push_back(c);
+            }
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Трассировка выполнения запросов в формате Chrome trace-event JSON
+ * (открывается в Perfetto / chrome://tracing).
+ *
+ * По умолчанию выключена. Пока трассировка выключена, TraceSpan
+ * не читает часы и ничего не записывает.
+ *
+ * Пример использования:
+ *
+ *  Tracer::Instance().Enable();
+ *  {
+ *      TraceSpan span("query"sv);
+ *      span.AddArg("term"sv, word);
+ *      span.AddArg("postings"sv, postings.size());
+ *      ...
+ *  }
+ *  Tracer::Instance().FlushToFile("trace.json"s);
+ */
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string name;
+        std::string args;
+        int64_t start_us = 0;
+        int64_t duration_us = 0;
+        int thread_id = 0;
+    };
+
+    static Tracer& Instance();
+
+    void Enable(size_t events_per_thread = DEFAULT_EVENTS_PER_THREAD);
+
+    void Disable();
+
+    bool IsEnabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    int64_t NowMicroseconds() const;
+
+    void Record(Event event);
+
+    // Пишет все накопленные события и очищает буферы потоков.
+    void Flush(std::ostream& out);
+
+    bool FlushToFile(const std::string& path);
+
+    static const size_t DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+
+private:
+    // Кольцевой буфер одного потока: при переполнении затираются самые старые события.
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::vector<Event> events;
+        size_t head = 0;
+        size_t size = 0;
+        int thread_id = 0;
+    };
+
+    Tracer() = default;
+
+    ThreadBuffer& GetThreadBuffer();
+
+    std::atomic<bool> enabled_{ false };
+    std::atomic<size_t> capacity_{ DEFAULT_EVENTS_PER_THREAD };
+    const Clock::time_point epoch_ = Clock::now();
+
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+};
+
+class TraceSpan {
+public:
+    explicit TraceSpan(std::string_view name);
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    ~TraceSpan();
+
+    void AddArg(std::string_view key, std::string_view value);
+
+    template <typename Number>
+    std::enable_if_t<std::is_arithmetic_v<Number>> AddArg(std::string_view key, Number value) {
+        if constexpr (std::is_floating_point_v<Number>) {
+            AddNumber(key, static_cast<double>(value));
+        }
+        else {
+            AddNumber(key, static_cast<int64_t>(value));
+        }
+    }
+
+    bool IsActive() const {
+        return active_;
+    }
+
+private:
+    void AppendKey(std::string_view key);
+
+    void AddNumber(std::string_view key, int64_t value);
+
+    void AddNumber(std::string_view key, double value);
+
+    bool active_;
+    Tracer::Event event_;
+};
+
+void AppendJsonEscaped(std::string& out, std::string_view text);